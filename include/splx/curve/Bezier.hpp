@@ -11,12 +11,21 @@
 #include <utility>
 #include <splx/internal/combinatorics.hpp>
 #include <splx/internal/bezier.hpp>
+#include <splx/policies.hpp>
 
 
 namespace splx {
 
+/*
+* Bezier curve. When DEGREE is Eigen::Dynamic (default), the degree is
+* defined by the number of control points, which can be changed at runtime.
+* Otherwise, the degree is fixed at compile time.
+*/
+template<typename T, unsigned int DIM, int DEGREE = Eigen::Dynamic>
+class Bezier;
+
 template<typename T, unsigned int DIM>
-class Bezier : public ParametricCurve<T, DIM> {
+class Bezier<T, DIM, Eigen::Dynamic> : public ParametricCurve<T, DIM> {
   public:
     using Base = ParametricCurve<T, DIM>;
 
@@ -27,6 +36,12 @@ class Bezier : public ParametricCurve<T, DIM> {
     using Row = typename ParametricCurve<T, DIM>::Row;
     using ControlPoints = typename ParametricCurve<T, DIM>::ControlPoints;
     using CurveType = typename ParametricCurve<T, DIM>::CurveType;
+    using MatrixDIMX = typename ParametricCurve<T, DIM>::MatrixDIMX;
+    using AlignedBox = typename ParametricCurve<T, DIM>::AlignedBox;
+    using StridedVector = Eigen::Ref<const Vector, 0, Eigen::InnerStride<>>;
+
+    static_assert(sizeof(VectorDIM) == DIM * sizeof(T),
+                  "control points must be stored contiguously");
 
     Bezier(): Base(CurveType::BEZIER), m_a(0) {
 
@@ -46,6 +61,18 @@ class Bezier : public ParametricCurve<T, DIM> {
 
     }
 
+    Bezier(T a, ControlPoints&& cpts) : Base(CurveType::BEZIER),
+                                        m_a(a),
+                                        m_controlPoints(std::move(cpts))
+    {
+      if(m_a < 0) {
+        throw std::domain_error(
+          std::string("max parameter should be non-negative. given ")
+          + std::to_string(m_a)
+        );
+      }
+    }
+
     Bezier(T a) : Base(CurveType::BEZIER), m_a(a) {
       if(m_a < 0) {
         throw std::domain_error(
@@ -90,11 +117,15 @@ class Bezier : public ParametricCurve<T, DIM> {
     Bezier& operator=(const Bezier<T, DIM>& rhs) { 
       this->m_a = rhs.m_a;
       this->m_controlPoints = rhs.m_controlPoints;
+      this->invalidateCaches();
+      return *this;
     }
 
     Bezier& operator=(Bezier<T, DIM>&& rhs) {
       this->m_a = rhs.m_a;
       this->m_controlPoints = std::move(rhs.m_controlPoints);
+      this->invalidateCaches();
+      return *this;
     }
 
     std::size_t numControlPoints() const override {
@@ -102,7 +133,12 @@ class Bezier : public ParametricCurve<T, DIM> {
     }
 
 
+    /*
+    * Invalidates cached coefficients since the returned control point
+    * may be modified.
+    */
     VectorDIM& operator[](std::size_t i) override {
+      this->invalidateCaches();
       return this->m_controlPoints[i];
     }
 
@@ -112,6 +148,7 @@ class Bezier : public ParametricCurve<T, DIM> {
 
     void appendControlPoint(const VectorDIM& cpt) override {
       this->m_controlPoints.push_back(cpt);
+      this->invalidateCaches();
     }
 
     void removeControlPoint(std::size_t idx) override {
@@ -122,6 +159,7 @@ class Bezier : public ParametricCurve<T, DIM> {
       }
 
       this->m_controlPoints.erase(this->m_controlPoints.begin() + idx);
+      this->invalidateCaches();
     }
 
     T maxParameter() const override {
@@ -137,6 +175,7 @@ class Bezier : public ParametricCurve<T, DIM> {
       }
 
       m_a = nw;
+      this->invalidateCaches();
     }
 
     unsigned int degree() const {
@@ -144,9 +183,45 @@ class Bezier : public ParametricCurve<T, DIM> {
     }
 
 
+    /*
+     * Highest degree evaluated with cached power basis coefficients. The
+     * power basis loses precision quickly with degree, so curves of higher
+     * degree are evaluated with horner's scheme for bernstein polynomials.
+    */
+    static constexpr unsigned int POWER_BASIS_MAX_DEGREE = 10;
+
+    /*
+     * Compute power basis coefficients of all derivatives of the curve, so
+     * that eval and evalMany are a horner sweep until the curve is modified.
+     * Does nothing for curves of degree above POWER_BASIS_MAX_DEGREE. The
+     * coefficients are not copied with the curve.
+     *
+     * Caching is opt-in because it modifies the curve: call it before
+     * sharing the curve between threads, never concurrently with eval.
+    */
+    void cachePowerBasis() {
+      if(!m_powerBasisCoefficients.empty()
+         || this->numControlPoints() == 0
+         || this->degree() > POWER_BASIS_MAX_DEGREE) {
+        return;
+      }
+
+      m_powerBasisCoefficients.resize(this->numControlPoints());
+      for(unsigned int k = 0; k <= this->degree(); k++) {
+        m_powerBasisCoefficients[k].noalias() = this->controlPointMatrix()
+          * splx::internal::bezier::bernsteinCoefficientMatrix(
+              this->degree(), this->maxParameter(), k
+            );
+      }
+    }
+
     /*
      * Evaluate k^th derivative of bezier curve at u = u.
      *
+     * Uses the power basis coefficients if cachePowerBasis has been called,
+     * horner's scheme for bernstein polynomials otherwise. Never modifies
+     * the curve, so const curves can be evaluated from multiple threads.
+     *
      * @fails if u > m_a
     */
     VectorDIM eval(T u, unsigned int k) const override {
@@ -158,23 +233,155 @@ class Bezier : public ParametricCurve<T, DIM> {
         );
       }
 
-      if(this->numControlPoints() == 0) {
-        VectorDIM zero;
-        zero.setZero();
-        return zero;
+      if(!this->usesPowerBasis(k)) {
+        return splx::internal::bezier::evalHorner(
+          this->controlPointMatrix(), this->maxParameter(), u, k
+        );
+      }
+
+      return this->evalPowerBasis(m_powerBasisCoefficients[k], u);
+    }
+
+    /*
+     * Evaluate k^th derivative of bezier curve at u = u for real time use.
+     * u is mapped to [0, m_a] with Policy (ClampPolicy, WrapPolicy or
+     * AssertPolicy). Does not use the cached coefficients, so it never
+     * allocates, and it never throws.
+    */
+    template<typename Policy>
+    VectorDIM eval(T u, unsigned int k) const noexcept {
+      return splx::internal::bezier::evalHorner(
+        this->controlPointMatrix(), this->maxParameter(),
+        Policy::apply(u, this->maxParameter()), k
+      );
+    }
+
+    /*
+     * Evaluate k^th derivative of bezier curve at each parameter in us.
+     * i^th column of the result is eval(us(i), k).
+     *
+     * @fails if any of us is outside [0, m_a]
+    */
+    MatrixDIMX evalMany(const Vector& us, unsigned int k) const {
+      MatrixDIMX result(DIM, us.size());
+      this->evalMany(us, k, result);
+      return result;
+    }
+
+    /*
+     * Strided variant of evalMany. Writes the results to the columns of result,
+     * which must have us.size() columns. Parameters are checked once.
+     *
+     * @fails if any of us is outside [0, m_a]
+    */
+    void evalMany(const StridedVector& us, unsigned int k,
+                  Eigen::Ref<MatrixDIMX> result) const {
+      if(result.cols() != us.size()) {
+        throw std::domain_error(
+          std::string("result column count does not match parameter count. given ")
+          + std::to_string(result.cols())
+          + std::string(", required ")
+          + std::to_string(us.size())
+        );
+      }
+
+      if(us.size() == 0) {
+        return;
+      }
+
+      if(us.minCoeff() < 0 || us.maxCoeff() > maxParameter()) {
+        throw std::domain_error(
+          std::string("u is outside of the range [0, ")
+          + std::to_string(maxParameter())
+          + std::string("]")
+        );
+      }
+
+      if(!this->usesPowerBasis(k)) {
+        for(Index i = 0; i < us.size(); i++) {
+          result.col(i) = splx::internal::bezier::evalHorner(
+            this->controlPointMatrix(), this->maxParameter(), us(i), k
+          );
+        }
+        return;
       }
 
-      Row basis = splx::internal::bezier::getBasisRow(this->degree(), this->maxParameter(), u, k);
-      VectorDIM result;
-      result.setZero();
+      const MatrixDIMX& coeffs = m_powerBasisCoefficients[k];
+      for(Index i = 0; i < us.size(); i++) {
+        result.col(i) = this->evalPowerBasis(coeffs, us(i));
+      }
+    }
 
-      for(typename std::size_t i = 0; i < this->numControlPoints(); i++) {
-        result += (*this)[i] * basis(i);
+    /*
+     * Evaluate 0th to kmax^th derivatives of bezier curve at u = u.
+     * k^th column of the result is eval(u, k).
+     *
+     * @fails if u > m_a
+    */
+    MatrixDIMX evalDerivatives(T u, unsigned int kmax) const {
+      if(u < 0 || u > maxParameter()) {
+        throw std::domain_error(
+          std::string("u is outside of the range [0, ")
+          + std::to_string(maxParameter())
+          + std::string("]")
+        );
       }
 
+      MatrixDIMX result(DIM, kmax + 1);
+      MatrixDIMX work(DIM, this->numControlPoints());
+      splx::internal::bezier::evalDerivatives(
+        this->controlPointMatrix(), this->maxParameter(), u, kmax, work, result
+      );
       return result;
     }
 
+    /*
+     * Returns the k^th derivative of the curve as a bezier curve of degree
+     * d-k defined on the same interval, i.e. derivative(k).eval(u, 0) is
+     * eval(u, k). Its control points are the scaled k^th differences of the
+     * control points, so convex hull queries such as onNegativeSide can be
+     * run on derivatives. If k > d, the result is a zero curve of degree 0.
+     *
+     * Derivatives are computed on first request and memoized, first
+     * derivative of the (k-1)^th derivative being the k^th. The returned
+     * reference is invalidated when the curve is modified.
+    */
+    const Bezier& derivative(unsigned int k) const {
+      if(k == 0) {
+        return *this;
+      }
+
+      if(!m_hodograph) {
+        m_hodograph = std::make_unique<Bezier>(m_a);
+        if(this->numControlPoints() == 1) {
+          m_hodograph->m_controlPoints.push_back(VectorDIM::Zero());
+        }
+        for(std::size_t i = 0; i + 1 < this->numControlPoints(); i++) {
+          if(m_a == 0) {
+            m_hodograph->m_controlPoints.push_back(VectorDIM::Zero());
+          } else {
+            m_hodograph->m_controlPoints.push_back(
+              (m_controlPoints[i+1] - m_controlPoints[i]) * (this->degree() / m_a)
+            );
+          }
+        }
+      }
+
+      return m_hodograph->derivative(k - 1);
+    }
+
+    /*
+     * View of the control points as a DIM x numControlPoints() matrix
+     * where i^th column is the i^th control point.
+    */
+    Eigen::Map<const MatrixDIMX> controlPointMatrix() const {
+      return Eigen::Map<const MatrixDIMX>(
+        m_controlPoints.empty() ? nullptr : m_controlPoints[0].data(),
+        DIM,
+        m_controlPoints.size()
+      );
+    }
+
 
     /*
     * Returns true if the curve is in the negative side of the hyperplane hp
@@ -215,6 +422,26 @@ class Bezier : public ParametricCurve<T, DIM> {
       return true;
     }
 
+    /*
+    * Returns the axis aligned bounding box of the control points, which
+    * contains the curve by the convex hull property. Computed on the first
+    * call and reused until the curve is modified.
+    */
+    const AlignedBox& boundingBox() const {
+      if(m_boundingBox.isEmpty()) {
+        if(this->numControlPoints() == 0) {
+          m_boundingBox = AlignedBox(VectorDIM::Zero());
+        } else {
+          m_boundingBox = AlignedBox(
+            this->controlPointMatrix().rowwise().minCoeff(),
+            this->controlPointMatrix().rowwise().maxCoeff()
+          );
+        }
+      }
+
+      return m_boundingBox;
+    }
+
   private:
     /**
      * Bezier curve is defined for u \in [0, m_a]
@@ -230,6 +457,269 @@ class Bezier : public ParametricCurve<T, DIM> {
      * Therefore, the degree d of the bezier is m_controlPoints.size() - 1
     */
     ControlPoints m_controlPoints;
+
+    /**
+     * m_powerBasisCoefficients[k] is the DIM x (d+1) matrix C such that
+     * f^k(u) = \sum_{j=0}^{d} C.col(j) u^j
+     * Empty unless filled by cachePowerBasis, in which case it has d+1
+     * slots. Cleared whenever the curve is modified.
+    */
+    std::vector<MatrixDIMX> m_powerBasisCoefficients;
+
+    /**
+     * First derivative of the curve. nullptr if not computed yet. Reset
+     * whenever the curve is modified.
+    */
+    mutable std::unique_ptr<Bezier> m_hodograph;
+
+    /**
+     * Bounding box of the control points. Empty if not computed yet. Reset
+     * whenever the curve is modified.
+    */
+    mutable AlignedBox m_boundingBox;
+
+    void invalidateCaches() {
+      m_powerBasisCoefficients.clear();
+      m_hodograph.reset();
+      m_boundingBox.setEmpty();
+    }
+
+    // true if the k^th derivative is evaluated with the power basis cache
+    bool usesPowerBasis(unsigned int k) const {
+      return !m_powerBasisCoefficients.empty() && k <= this->degree();
+    }
+
+    // evaluate power basis polynomial with given coefficients at u
+    static VectorDIM evalPowerBasis(const MatrixDIMX& coeffs, T u) {
+      VectorDIM result = coeffs.col(coeffs.cols() - 1);
+      for(Index j = coeffs.cols() - 2; j >= 0; j--) {
+        result = result * u + coeffs.col(j);
+      }
+      return result;
+    }
+};
+
+
+/*
+* Bezier curve with degree fixed at compile time.
+*
+* Control points are stored in a fixed size matrix, so the curve does not
+* allocate and does not have virtual functions. It provides the same
+* functions as ParametricCurve except the ones that change the number of
+* control points. Use dynamic() to get an equivalent Bezier<T, DIM>, e.g. to
+* add it to a PiecewiseCurve.
+*/
+template<typename T, unsigned int DIM, int DEGREE>
+class Bezier {
+  public:
+    static_assert(DEGREE >= 0, "degree of bezier curve must be non-negative");
+
+    static constexpr unsigned int NUM_CONTROL_POINTS = DEGREE + 1;
+
+    using VectorDIM = typename ParametricCurve<T, DIM>::VectorDIM;
+    using Hyperplane = typename ParametricCurve<T, DIM>::Hyperplane;
+    using AlignedBox = typename ParametricCurve<T, DIM>::AlignedBox;
+    using ControlPoints = Eigen::Matrix<T, DIM, NUM_CONTROL_POINTS>;
+    using _DynamicBezier = Bezier<T, DIM>;
+
+    Bezier(): m_a(0) {
+      m_controlPoints.setZero();
+    }
+
+    Bezier(T a, const ControlPoints& cpts): m_a(a), m_controlPoints(cpts) {
+      this->maxParameterCheck(a);
+    }
+
+    /*
+    * Construct from a dynamic bezier with DEGREE + 1 control points
+    */
+    explicit Bezier(const _DynamicBezier& bez): m_a(bez.maxParameter()) {
+      if(bez.numControlPoints() != NUM_CONTROL_POINTS) {
+        throw std::domain_error(
+          std::string("number of control points should be ")
+          + std::to_string(NUM_CONTROL_POINTS)
+          + std::string(". given ")
+          + std::to_string(bez.numControlPoints())
+        );
+      }
+
+      m_controlPoints = bez.controlPointMatrix();
+    }
+
+    /*
+    * Returns the equivalent bezier curve with dynamic degree
+    */
+    _DynamicBezier dynamic() const {
+      typename _DynamicBezier::ControlPoints cpts;
+      for(unsigned int i = 0; i < NUM_CONTROL_POINTS; i++) {
+        cpts.push_back(m_controlPoints.col(i));
+      }
+      return _DynamicBezier(m_a, cpts);
+    }
+
+    static constexpr std::size_t numControlPoints() {
+      return NUM_CONTROL_POINTS;
+    }
+
+    static constexpr unsigned int degree() {
+      return DEGREE;
+    }
+
+    typename ControlPoints::ColXpr operator[](std::size_t i) {
+      return m_controlPoints.col(i);
+    }
+
+    typename ControlPoints::ConstColXpr operator[](std::size_t i) const {
+      return m_controlPoints.col(i);
+    }
+
+    const ControlPoints& controlPointMatrix() const {
+      return m_controlPoints;
+    }
+
+    T maxParameter() const {
+      return m_a;
+    }
+
+    void maxParameter(T nw) {
+      this->maxParameterCheck(nw);
+      m_a = nw;
+    }
+
+    /*
+     * Evaluate k^th derivative of bezier curve at u = u.
+     *
+     * Position is evaluated as the product of the control point matrix with
+     * bernstein basis values computed from compile time binomials.
+     * Derivatives are evaluated on the hodograph.
+     *
+     * @fails if u > m_a
+    */
+    VectorDIM eval(T u, unsigned int k) const {
+      if(u < 0 || u > m_a) {
+        throw std::domain_error(
+          std::string("u is outside of the range [0, ")
+          + std::to_string(m_a)
+          + std::string("]")
+        );
+      }
+
+      if(k != 0 || m_a == 0) {
+        return splx::internal::bezier::evalHorner(m_controlPoints, m_a, u, k);
+      }
+
+      constexpr std::array<T, NUM_CONTROL_POINTS> binomials
+            = splx::internal::binomialRow<T, DEGREE>();
+
+      const T t = u / m_a;
+      const T s = 1 - t;
+      std::array<T, NUM_CONTROL_POINTS> tPow, sPow;
+      tPow[0] = sPow[0] = 1;
+      for(unsigned int i = 1; i < NUM_CONTROL_POINTS; i++) {
+        tPow[i] = tPow[i-1] * t;
+        sPow[i] = sPow[i-1] * s;
+      }
+
+      Eigen::Matrix<T, NUM_CONTROL_POINTS, 1> basis;
+      for(unsigned int i = 0; i < NUM_CONTROL_POINTS; i++) {
+        basis(i) = binomials[i] * tPow[i] * sPow[DEGREE - i];
+      }
+
+      return m_controlPoints * basis;
+    }
+
+    /*
+     * Evaluate k^th derivative of bezier curve at u = u for real time use.
+     * u is mapped to [0, m_a] with Policy (ClampPolicy, WrapPolicy or
+     * AssertPolicy). Never allocates or throws.
+    */
+    template<typename Policy>
+    VectorDIM eval(T u, unsigned int k) const noexcept {
+      return splx::internal::bezier::evalHorner(
+        m_controlPoints, m_a, Policy::apply(u, m_a), k
+      );
+    }
+
+    /*
+     * Evaluate 0th to KMAX^th derivatives of bezier curve at u = u.
+     * k^th column of the result is eval(u, k). Does not allocate.
+     *
+     * @fails if u > m_a
+    */
+    template<unsigned int KMAX>
+    Eigen::Matrix<T, DIM, KMAX + 1> evalDerivatives(T u) const {
+      if(u < 0 || u > m_a) {
+        throw std::domain_error(
+          std::string("u is outside of the range [0, ")
+          + std::to_string(m_a)
+          + std::string("]")
+        );
+      }
+
+      Eigen::Matrix<T, DIM, KMAX + 1> result;
+      ControlPoints work = ControlPoints::Zero();
+      splx::internal::bezier::evalDerivatives(
+        m_controlPoints, m_a, u, KMAX, work, result
+      );
+      return result;
+    }
+
+    /*
+    * Returns true if the curve is in the negative side of the hyperplane hp
+    * leverage convex hull property
+    */
+    bool onNegativeSide(const Hyperplane& hp) const {
+      for(unsigned int i = 0; i < NUM_CONTROL_POINTS; i++) {
+        if(hp.signedDistance(m_controlPoints.col(i)) >= 0)
+          return false;
+      }
+      return true;
+    }
+
+    /*
+    * Returns true if the curve is in the non-positive side of the hyperplane hp
+    * leverage convex hull property
+    */
+    bool onNonPositiveSide(const Hyperplane& hp) const {
+      for(unsigned int i = 0; i < NUM_CONTROL_POINTS; i++) {
+        if(hp.signedDistance(m_controlPoints.col(i)) > 0)
+          return false;
+      }
+      return true;
+    }
+
+    /*
+    * Returns the axis aligned bounding box of the control points, which
+    * contains the curve by the convex hull property.
+    */
+    AlignedBox boundingBox() const {
+      return AlignedBox(
+        m_controlPoints.rowwise().minCoeff(),
+        m_controlPoints.rowwise().maxCoeff()
+      );
+    }
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  private:
+    /**
+     * Bezier curve is defined for u \in [0, m_a]
+    */
+    T m_a;
+
+    /**
+     * i^th column is the i^th control point
+    */
+    ControlPoints m_controlPoints;
+
+    void maxParameterCheck(T a) const {
+      if(a < 0) {
+        throw std::domain_error(
+          std::string("max parameter should be non-negative. given ")
+          + std::to_string(a)
+        );
+      }
+    }
 };
 
 }
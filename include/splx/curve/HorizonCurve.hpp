@@ -0,0 +1,330 @@
+#ifndef SPLX_HORIZONCURVE_HPP
+#define SPLX_HORIZONCURVE_HPP
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <splx/curve/ParametricCurve.hpp>
+#include <splx/curve/Bezier.hpp>
+#include <splx/policies.hpp>
+
+namespace splx {
+
+/*
+* Piecewise bezier curve for receding horizon planning, where consumed
+* pieces are removed from the front and new pieces are appended to the back.
+*
+* Pieces are stored in a ring buffer, so pushBack and popFront take O(1)
+* amortized time and reuse the storage of removed pieces. Piece end times
+* are kept on an internal clock that is not shifted when pieces are
+* removed. Instead, the time of the first piece is kept as an offset, and
+* end times are rebased once every time the ring buffer wraps around.
+*
+* As in PiecewiseCurve, the curve is defined for u \in [0, maxParameter()]
+* where u = 0 is the start of the first piece.
+*/
+template<typename T, unsigned int DIM>
+class HorizonCurve {
+public:
+    using _Bezier = splx::Bezier<T, DIM>;
+    using VectorDIM = typename _Bezier::VectorDIM;
+    using MatrixDIMX = typename _Bezier::MatrixDIMX;
+
+    HorizonCurve(): m_head(0), m_size(0), m_offset(0), m_startTime(0) {
+
+    }
+
+    /*
+    * Appends a piece to the back of the curve by copying it. bez may be a
+    * piece of this curve, e.g. back().
+    */
+    void pushBack(const _Bezier& bez) {
+        if(m_size == m_slots.size()) {
+            this->growAndPushBack(bez);
+            return;
+        }
+
+        const std::size_t slot = this->slotIndex(m_size);
+        m_slots[slot] = bez;
+        m_ends[slot] = this->pieceStart(m_size) + bez.maxParameter();
+        m_size++;
+    }
+
+    /*
+    * Appends a fixed degree piece to the back of the curve by copying it.
+    */
+    template<int DEGREE>
+    void pushBack(const splx::Bezier<T, DIM, DEGREE>& bez) {
+        this->pushBack(bez.dynamic());
+    }
+
+    /*
+    * Removes the first piece. Parameters of the remaining pieces are shifted
+    * so that the curve starts at the start of the new first piece.
+    */
+    void popFront() {
+        this->emptyPiecesCheck();
+
+        const T duration = m_slots[m_head].maxParameter();
+        m_offset = m_ends[m_head];
+        m_startTime += duration;
+        m_head = (m_head + 1) % m_slots.size();
+        m_size--;
+
+        if(m_size == 0 || m_head == 0) {
+            this->rebase();
+        }
+    }
+
+    /*
+    * Removes the part of the curve after parameter u. The piece that
+    * contains u is subdivided so that the curve does not change on [0, u].
+    * Takes O(number of removed pieces + d^2). truncateAfter(0) removes all
+    * pieces.
+    */
+    void truncateAfter(T u) {
+        this->parameterBoundCheck(u);
+
+        const T t = m_offset + u;
+        while(m_size != 0 && this->pieceStart(m_size - 1) >= t) {
+            m_size--;
+        }
+
+        if(m_size == 0) {
+            this->rebase();
+            return;
+        }
+
+        const std::size_t slot = this->slotIndex(m_size - 1);
+        if(m_ends[slot] > t) {
+            subdivideLeft(m_slots[slot], t - this->pieceStart(m_size - 1));
+            m_ends[slot] = t;
+        }
+    }
+
+    // removes all pieces
+    void clear() {
+        m_size = 0;
+        this->rebase();
+    }
+
+    // get number of pieces
+    std::size_t numPieces() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    // get piece with given index, where piece 0 is the first piece
+    const _Bezier& operator[](std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return m_slots[this->slotIndex(idx)];
+    }
+    const _Bezier& getPiece(std::size_t idx) const {
+        return this->operator[](idx);
+    }
+
+    // get first piece
+    const _Bezier& front() const {
+        this->emptyPiecesCheck();
+        return m_slots[m_head];
+    }
+
+    // get last piece
+    const _Bezier& back() const {
+        this->emptyPiecesCheck();
+        return m_slots[this->slotIndex(m_size - 1)];
+    }
+
+    /*
+    * Sum of max parameters of all pieces removed by popFront, i.e. the time
+    * of u = 0 if the curve started at time 0.
+    */
+    T startTime() const {
+        return m_startTime;
+    }
+
+    T maxParameter() const {
+        this->emptyPiecesCheck();
+        return m_ends[this->slotIndex(m_size - 1)] - m_offset;
+    }
+
+    /*
+    * evaluate the kth derivative of the curve at parameter u. does not use
+    * the caches of the pieces, so it is safe to call from multiple threads.
+    */
+    VectorDIM eval(T u, unsigned int k) const {
+        this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(m_offset + u);
+        return m_slots[this->slotIndex(idx)].template eval<ClampPolicy>(
+                m_offset + u - this->pieceStart(idx), k
+        );
+    }
+
+    /*
+    * evaluate the kth derivative of the curve at parameter u for real time
+    * use. u is mapped to [0, maxParameter()] with Policy (ClampPolicy,
+    * WrapPolicy or AssertPolicy). Never allocates or throws. Returns zero for
+    * an empty curve.
+    */
+    template<typename Policy>
+    VectorDIM eval(T u, unsigned int k) const noexcept {
+        if(m_size == 0) {
+            return VectorDIM::Zero();
+        }
+
+        const T t = m_offset + Policy::apply(
+            u, m_ends[this->slotIndex(m_size - 1)] - m_offset
+        );
+        auto idx = std::min(this->pieceIndex(t), m_size - 1);
+        return m_slots[this->slotIndex(idx)].template eval<ClampPolicy>(
+                t - this->pieceStart(idx), k
+        );
+    }
+
+    /*
+    * evaluate 0th to kmax^th derivatives of the curve at parameter u.
+    * k^th column of the result is eval(u, k).
+    */
+    MatrixDIMX evalDerivatives(T u, unsigned int kmax) const {
+        this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(m_offset + u);
+        const _Bezier& piece = m_slots[this->slotIndex(idx)];
+        return piece.evalDerivatives(
+                std::min(m_offset + u - this->pieceStart(idx), piece.maxParameter()),
+                kmax
+        );
+    }
+
+private:
+    /*
+    * Ring buffer of pieces. Piece i is stored in
+    * m_slots[(m_head + i) % m_slots.size()] for i < m_size. Slots of removed
+    * pieces are kept to reuse their storage.
+    */
+    std::vector<_Bezier> m_slots;
+
+    /*
+    * m_ends[s] is the time where the piece in slot s ends on the internal
+    * clock.
+    */
+    std::vector<T> m_ends;
+
+    std::size_t m_head;
+    std::size_t m_size;
+
+    /*
+    * Time where the first piece starts on the internal clock.
+    */
+    T m_offset;
+
+    T m_startTime;
+
+    std::size_t slotIndex(std::size_t idx) const noexcept {
+        return (m_head + idx) % m_slots.size();
+    }
+
+    // time where piece idx starts on the internal clock
+    T pieceStart(std::size_t idx) const noexcept {
+        return idx == 0 ? m_offset : m_ends[this->slotIndex(idx - 1)];
+    }
+
+    // index of the piece that contains time t of the internal clock
+    std::size_t pieceIndex(T t) const noexcept {
+        std::size_t lo = 0, hi = m_size;
+        while(lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if(m_ends[this->slotIndex(mid)] < t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /*
+    * doubles the capacity of the ring buffer and appends bez, first piece is
+    * moved to slot 0. bez is copied before the old slots are moved from, so
+    * it may refer to one of them.
+    */
+    void growAndPushBack(const _Bezier& bez) {
+        const std::size_t capacity = std::max<std::size_t>(1, 2 * m_slots.size());
+        std::vector<_Bezier> slots(capacity);
+        std::vector<T> ends(capacity);
+        slots[m_size] = bez;
+        ends[m_size] = this->pieceStart(m_size) + bez.maxParameter();
+        for(std::size_t i = 0; i < m_size; i++) {
+            slots[i] = std::move(m_slots[this->slotIndex(i)]);
+            ends[i] = m_ends[this->slotIndex(i)];
+        }
+
+        m_slots = std::move(slots);
+        m_ends = std::move(ends);
+        m_head = 0;
+        m_size++;
+    }
+
+    // shifts the internal clock so that the first piece starts at 0
+    void rebase() {
+        for(std::size_t i = 0; i < m_size; i++) {
+            m_ends[this->slotIndex(i)] -= m_offset;
+        }
+        m_offset = 0;
+    }
+
+    /*
+    * replaces bez with its part on [0, u] using de casteljau's algorithm.
+    * after the r^th pass, control point i is the first point of level i for
+    * i <= r.
+    */
+    static void subdivideLeft(_Bezier& bez, T u) {
+        const std::size_t numControlPoints = bez.numControlPoints();
+        if(bez.maxParameter() != 0) {
+            const T t = u / bez.maxParameter();
+            for(std::size_t level = 1; level < numControlPoints; level++) {
+                for(std::size_t i = numControlPoints - 1; i >= level; i--) {
+                    bez[i] = (1 - t) * bez[i-1] + t * bez[i];
+                }
+            }
+        }
+        bez.maxParameter(u);
+    }
+
+    void pieceIndexCheck(std::size_t idx) const { // checks if piece index is valid
+        if(idx >= m_size) {
+            throw std::domain_error(
+                std::string("piece index used is ")
+                + std::to_string(idx)
+                + std::string(" while piece count is ")
+                + std::to_string(m_size)
+            );
+        }
+    }
+
+    void emptyPiecesCheck() const { // checks if there is at least one piece.
+        if(m_size == 0) {
+            throw std::logic_error(
+                std::string("horizon curve is empty.")
+            );
+        }
+    }
+
+    void parameterBoundCheck(T u) const { // checks if given parameter is valid
+        const T maxParam = this->maxParameter();
+        if(u < 0 || u > maxParam) {
+            throw std::domain_error(
+                std::string("given parameter is out of bounds. given u: ")
+                + std::to_string(u)
+                + std::string(", allowed range: [0, ")
+                + std::to_string(maxParam)
+                + std::string("]")
+            );
+        }
+    }
+};
+
+} // namespace splx
+
+#endif
@@ -18,6 +18,7 @@ public:
   using Row = Eigen::Matrix<T, 1, Eigen::Dynamic>;
   using AlignedBox = Eigen::AlignedBox<T, DIM>;
   using ControlPoints = std::vector<VectorDIM, Eigen::aligned_allocator<VectorDIM>>;
+  using MatrixDIMX = Eigen::Matrix<T, DIM, Eigen::Dynamic>;
 
   enum class CurveType {
     LINEAR,
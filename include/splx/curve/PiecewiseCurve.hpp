@@ -1,8 +1,20 @@
 #ifndef SPLX_PIECEWISECURVE_HPP
 #define SPLX_PIECEWISECURVE_HPP
+#include <map>
 #include <memory>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <splx/types.hpp>
 #include <splx/curve/ParametricCurve.hpp>
 #include <splx/curve/Bezier.hpp>
+#include <splx/internal/bezier.hpp>
+#include <splx/internal/fenwick.hpp>
+#include <splx/internal/quadrature.hpp>
+#include <splx/policies.hpp>
 
 namespace splx {
 
@@ -13,6 +25,15 @@ public:
     using _Bezier = splx::Bezier<T, DIM>;
     using CurveType = typename _ParametricCurve::CurveType;
     using VectorDIM = typename _ParametricCurve::VectorDIM;
+    using Vector = typename _ParametricCurve::Vector;
+    using MatrixDIMX = typename _ParametricCurve::MatrixDIMX;
+    using StridedVector = typename _Bezier::StridedVector;
+    using ControlPoints = typename _ParametricCurve::ControlPoints;
+    using Matrix = splx::Matrix<T>;
+    using AlignedBox = typename _ParametricCurve::AlignedBox;
+
+    static_assert(sizeof(VectorDIM) == DIM * sizeof(T),
+                  "control points must be stored contiguously");
 
     PiecewiseCurve() {
 
@@ -22,154 +43,1174 @@ public:
 
     }
 
+    PiecewiseCurve(const PiecewiseCurve&) = default;
+    PiecewiseCurve(PiecewiseCurve&&) = default;
+    PiecewiseCurve& operator=(const PiecewiseCurve&) = default;
+    PiecewiseCurve& operator=(PiecewiseCurve&&) = default;
+
     /*
-    * Adds a bezier piece to the curve by creating a copy.
+    * Adds a bezier piece to the curve by copying its control points.
     */
     void addPiece(const _Bezier& bez) {
-        std::shared_ptr<_Bezier> bezptr = std::make_shared<_Bezier>(bez);
-        std::shared_ptr<_ParametricCurve> paramptr = std::static_pointer_cast<_ParametricCurve>(bezptr);
-        m_pieces.push_back(paramptr);
+        Piece piece;
+        piece.offset = m_controlPoints.size();
+        piece.numControlPoints = bez.numControlPoints();
+        for(std::size_t i = 0; i < bez.numControlPoints(); i++) {
+            m_controlPoints.push_back(bez[i]);
+        }
+        m_pieces.push_back(piece);
+        m_boundingBoxes.push_back(bez.boundingBox());
+        m_boundingVolumes.clear();
+        this->pushDuration(bez.maxParameter());
+        this->invalidateCaches();
+    }
+
+    /*
+    * Adds a bezier piece with max parameter a whose control points are the
+    * columns of cpts, e.g. a Map over a solution vector. Control points are
+    * written into the curve directly without constructing a bezier.
+    */
+    template<typename Derived>
+    void emplacePiece(T a, const Eigen::MatrixBase<Derived>& cpts) {
+        static_assert(Derived::RowsAtCompileTime == DIM
+                      || Derived::RowsAtCompileTime == Eigen::Dynamic,
+                      "control points must have DIM rows");
+        if(a < 0) {
+            throw std::domain_error(
+                std::string("max parameter should be non-negative. given ")
+                + std::to_string(a)
+            );
+        }
+        if(cpts.rows() != DIM) {
+            throw std::domain_error(
+                std::string("control points must have ")
+                + std::to_string(DIM)
+                + std::string(" rows. given ")
+                + std::to_string(cpts.rows())
+            );
+        }
 
-        this->addNewCurveMaxParameter(bez.maxParameter());
+        Piece piece;
+        piece.offset = m_controlPoints.size();
+        piece.numControlPoints = cpts.cols();
+        m_controlPoints.resize(piece.offset + piece.numControlPoints);
+        for(std::size_t i = 0; i < piece.numControlPoints; i++) {
+            m_controlPoints[piece.offset + i] = cpts.col(i);
+        }
+        m_pieces.push_back(piece);
+        if(piece.numControlPoints == 0) {
+            m_boundingBoxes.push_back(AlignedBox(VectorDIM::Zero()));
+        } else {
+            const auto matrix = this->controlPointMatrix(m_pieces.size() - 1);
+            m_boundingBoxes.push_back(AlignedBox(
+                matrix.rowwise().minCoeff(), matrix.rowwise().maxCoeff()
+            ));
+        }
+        m_boundingVolumes.clear();
+        this->pushDuration(a);
+        this->invalidateCaches();
     }
 
     /*
-    * Adds a bezier piece to the curve directly. The object must not be destroyed outside!
+    * Reserves space for numPieces pieces with numControlPoints control points
+    * in total, so that adding them does not reallocate.
     */
-    void addPiece(std::shared_ptr<_Bezier> bezptr) {
-        std::shared_ptr<_ParametricCurve> paramptr =  std::static_pointer_cast<_ParametricCurve>(bezptr);
-        m_pieces.push_back(paramptr);
+    void reserve(std::size_t numPieces, std::size_t numControlPoints) {
+        m_controlPoints.reserve(numControlPoints);
+        m_pieces.reserve(numPieces);
+        m_boundingBoxes.reserve(numPieces);
+        m_durations.reserve(numPieces);
+    }
+
+    /*
+    * Adds a fixed degree bezier piece to the curve by copying its control
+    * points.
+    */
+    template<int DEGREE>
+    void addPiece(const splx::Bezier<T, DIM, DEGREE>& bez) {
+        this->addPiece(bez.dynamic());
+    }
 
-        this->addNewCurveMaxParameter(bezptr->maxParameter());
+    /*
+    * Adds a bezier piece to the curve by copying its control points. Unlike
+    * before pieces were stored in a flat buffer, the curve does not share
+    * the given bezier: later modifications to it do not change the curve.
+    */
+    void addPiece(std::shared_ptr<_Bezier> bezptr) {
+        this->addPiece(*bezptr);
     }
 
-    // add a piece directly
+    /*
+    * Adds a piece to the curve by copying its control points. Only bezier
+    * pieces are supported.
+    */
     void addPiece(std::shared_ptr<_ParametricCurve> pieceptr) {
-        m_pieces.push_back(pieceptr);
-        this->addNewCurveMaxParameter(pieceptr->maxParameter());
+        this->addPiece(this->asBezier(*pieceptr));
     }
 
     /*
-    * Sets a specific piece to the given bezier. Given bezier is copied
+    * Sets a specific piece to the given bezier. Given bezier is copied.
+    * Takes O(log n) if the number of control points does not change.
     */
     void setPiece(std::size_t idx, const _Bezier& bez) {
         this->pieceIndexCheck(idx);
 
-        std::shared_ptr<_Bezier> bezptr = std::make_shared<_Bezier>(bez);
-        std::shared_ptr<_ParametricCurve> paramptr = std::static_pointer_cast<_ParametricCurve>(bezptr);
-        m_pieces[idx] = paramptr;
+        Piece& piece = m_pieces[idx];
+        const std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(bez.numControlPoints())
+                                   - static_cast<std::ptrdiff_t>(piece.numControlPoints);
+        if(shift > 0) {
+            m_controlPoints.insert(
+                m_controlPoints.begin() + piece.offset + piece.numControlPoints,
+                shift, VectorDIM::Zero()
+            );
+        } else if(shift < 0) {
+            m_controlPoints.erase(
+                m_controlPoints.begin() + piece.offset + bez.numControlPoints(),
+                m_controlPoints.begin() + piece.offset + piece.numControlPoints
+            );
+        }
+        if(shift != 0) {
+            for(std::size_t i = idx + 1; i < m_pieces.size(); i++) {
+                m_pieces[i].offset += shift;
+            }
+        }
+
+        piece.numControlPoints = bez.numControlPoints();
+        for(std::size_t i = 0; i < bez.numControlPoints(); i++) {
+            m_controlPoints[piece.offset + i] = bez[i];
+        }
 
-        this->fixCumulativeParameters(idx);
+        m_boundingBoxes[idx] = bez.boundingBox();
+        this->refitBoundingVolumes(idx);
+        this->setDuration(idx, bez.maxParameter());
+        this->invalidateCaches();
     }
 
     /*
-    * Sets a specific piece to the given bezier. Given bezier must not be destroyed outside!
+    * Sets a specific piece to the given bezier. Given bezier is copied, so
+    * the curve does not share it, unlike before pieces were stored in a
+    * flat buffer.
     */
     void setPiece(std::size_t idx, std::shared_ptr<_Bezier> bezptr) {
-        this->pieceIndexCheck(idx);
-
-        auto paramptr = std::static_pointer_cast<_ParametricCurve>(bezptr);
-        m_pieces[idx] = paramptr;
-
-        this->fixCumulativeParameters(idx);
+        this->setPiece(idx, *bezptr);
     }
 
+    /*
+    * Sets a specific piece to the given piece. Given piece is copied. Only
+    * bezier pieces are supported.
+    */
     void setPiece(std::size_t idx, std::shared_ptr<_ParametricCurve> pieceptr) {
+        this->setPiece(idx, this->asBezier(*pieceptr));
+    }
+
+    /*
+    * Sets the max parameter of a specific piece without changing its control
+    * points. Takes O(log n).
+    */
+    void setPieceMaxParameter(std::size_t idx, T maxParameter) {
         this->pieceIndexCheck(idx);
-        m_pieces[idx] = pieceptr;
-        this->fixCumulativeParameters(idx);
+        if(maxParameter < 0) {
+            throw std::domain_error(
+                std::string("max parameter should be non-negative. given ")
+                + std::to_string(maxParameter)
+            );
+        }
+
+        this->setDuration(idx, maxParameter);
+        this->invalidateCaches();
+    }
+
+    /*
+    * Returns true if all pieces have the same max parameter. Pieces are
+    * then found in O(1) by dividing the parameter by the max parameter.
+    */
+    bool hasUniformDurations() const {
+        return m_durationCounts.size() <= 1;
     }
 
     // get number of pieces
     std::size_t numPieces() const {
-        return this->m_cumulativeParameters.size();
+        return this->m_pieces.size();
     }
 
 
-    // get piece with given index
-    const _Bezier& operator[](std::size_t idx) const {
-        this->pieceIndexCheck(idx);
+    /*
+    * Read only view of a piece of the curve. Evaluates the piece on the
+    * control point buffer of the curve, so it neither copies nor allocates.
+    * Converts to a bezier when a copy of the piece is needed.
+    *
+    * The view refers to the curve, which must outlive it. It is invalidated
+    * when pieces of the curve are added or set.
+    */
+    class PieceView {
+    public:
+        PieceView(const PiecewiseCurve& curve, std::size_t idx)
+            : m_curve(&curve), m_idx(idx) {
 
-        if(m_pieces[idx]->type != CurveType::BEZIER) {
-            throw std::domain_error(
-                std::string("piece with index ")
-                + std::to_string(idx)
-                + std::string(" is not a bezier")
+        }
+
+        // get the max parameter of the piece
+        T maxParameter() const {
+            return m_curve->m_durations[m_idx];
+        }
+
+        std::size_t numControlPoints() const {
+            return m_curve->m_pieces[m_idx].numControlPoints;
+        }
+
+        unsigned int degree() const {
+            return this->numControlPoints() - 1;
+        }
+
+        // get the control point with given index
+        const VectorDIM& operator[](std::size_t i) const {
+            return m_curve->m_controlPoints[m_curve->m_pieces[m_idx].offset + i];
+        }
+
+        // control points of the piece as columns of a matrix
+        Eigen::Map<const MatrixDIMX> controlPointMatrix() const {
+            return m_curve->controlPointMatrix(m_idx);
+        }
+
+        // bounding box of the control points of the piece
+        const AlignedBox& boundingBox() const {
+            return m_curve->m_boundingBoxes[m_idx];
+        }
+
+        /*
+        * evaluate the kth derivative of the piece at parameter u of the
+        * piece.
+        *
+        * @fails if u is outside [0, maxParameter()]
+        */
+        VectorDIM eval(T u, unsigned int k) const {
+            if(u < 0 || u > this->maxParameter()) {
+                throw std::domain_error(
+                    std::string("u is outside of the range [0, ")
+                    + std::to_string(this->maxParameter())
+                    + std::string("]")
+                );
+            }
+            return m_curve->evalPiece(m_idx, u, k);
+        }
+
+        /*
+        * evaluate the kth derivative of the piece for real time use. u is
+        * mapped to [0, maxParameter()] with Policy.
+        */
+        template<typename Policy>
+        VectorDIM eval(T u, unsigned int k) const noexcept {
+            return m_curve->evalPiece(
+                m_idx, Policy::apply(u, this->maxParameter()), k
             );
         }
 
-        auto bezptr = std::static_pointer_cast<_Bezier>(m_pieces[idx]);
-        return *bezptr;
+        // copy of the piece
+        operator _Bezier() const {
+            const Piece& piece = m_curve->m_pieces[m_idx];
+            return _Bezier(
+                this->maxParameter(),
+                ControlPoints(
+                    m_curve->m_controlPoints.begin() + piece.offset,
+                    m_curve->m_controlPoints.begin() + piece.offset + piece.numControlPoints
+                )
+            );
+        }
+
+    private:
+        const PiecewiseCurve* m_curve;
+        std::size_t m_idx;
+    };
+
+    /*
+    * get a view of the piece with given index. Before pieces were stored in
+    * a flat buffer this returned const _Bezier&. The view has the read only
+    * interface of a bezier and converts to one, but auto binds to the view,
+    * which is invalidated when pieces are added or set.
+    */
+    PieceView operator[](std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return PieceView(*this, idx);
     }
-    const _Bezier& getPiece(std::size_t idx) const {
+    PieceView getPiece(std::size_t idx) const {
         return this->operator[](idx);
     }
 
+    /*
+    * View of the control points of the piece with given index as a
+    * DIM x numControlPoints matrix. Does not copy. Invalidated when pieces
+    * are added or set.
+    */
+    Eigen::Map<const MatrixDIMX> pieceControlPoints(std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return this->controlPointMatrix(idx);
+    }
+
+    // get the max parameter of the piece with given index
+    T pieceMaxParameter(std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return m_durations[idx];
+    }
+
+    /*
+    * get the bounding box of the control points of the piece with given
+    * index, which contains the piece. Computed when the piece is added or
+    * set.
+    */
+    const AlignedBox& pieceBoundingBox(std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return m_boundingBoxes[idx];
+    }
+
+    // get the bounding box of the whole curve
+    const AlignedBox& boundingBox() const {
+        this->emptyPiecesCheck();
+        return this->boundingVolumes()[1];
+    }
+
+    /*
+    * indices of the pieces whose bounding boxes intersect region, in
+    * increasing order. Pieces in the result may not enter the region, but
+    * pieces not in the result do not.
+    *
+    * A bounding volume hierarchy over pieces is built on the first query
+    * and reused. It is refit in O(log n) when a piece is set and rebuilt
+    * when a piece is added. Queries take O(log n + hits) for curves that
+    * do not revisit the same regions. Since the hierarchy is built lazily,
+    * concurrent calls on the same curve are not safe until it is built,
+    * e.g. by buildCaches.
+    */
+    std::vector<std::size_t> piecesIntersecting(const AlignedBox& region) const {
+        return this->queryBoundingVolumes([&region](const AlignedBox& box) {
+            return box.intersects(region);
+        });
+    }
+
+    /*
+    * indices of the pieces whose bounding boxes are within distance of
+    * point, in increasing order. Pieces not in the result are farther than
+    * distance from point.
+    */
+    std::vector<std::size_t> piecesNear(const VectorDIM& point, T distance) const {
+        return this->queryBoundingVolumes([&point, distance](const AlignedBox& box) {
+            return !box.isEmpty() && box.squaredExteriorDistance(point) <= distance * distance;
+        });
+    }
+
+    /*
+    * builds the arc length table and the bounding volume hierarchy, which
+    * are otherwise built by the first query that needs them. Afterwards
+    * queries only read the curve, so the curve can be queried from
+    * multiple threads until it is modified.
+    */
+    void buildCaches() const {
+        this->arcLengthTable();
+        this->boundingVolumes();
+    }
+
     // get the type of the piece with the given index
     CurveType type(std::size_t idx) const {
         this->pieceIndexCheck(idx);
-        return m_pieces[idx]->type;
+        return CurveType::BEZIER;
     }
 
 
     // evaluate the kth derivative at piecewise curve at parameter u
     VectorDIM eval(T u, unsigned int k) const {
         this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(u);
+        return this->evalPiece(idx, u - this->pieceStart(idx), k);
+    }
+
+    /*
+    * evaluate the kth derivative of piecewise curve at parameter u for
+    * real time use. u is mapped to [0, maxParameter()] with Policy
+    * (ClampPolicy, WrapPolicy or AssertPolicy). Never allocates or throws.
+    * Returns zero for an empty curve.
+    */
+    template<typename Policy>
+    VectorDIM eval(T u, unsigned int k) const noexcept {
+        if(m_pieces.empty()) {
+            return VectorDIM::Zero();
+        }
+
+        u = Policy::apply(u, this->totalDuration());
+        auto idx = std::min(this->pieceIndex(u), this->numPieces() - 1);
+        return this->evalPiece(idx, u - this->pieceStart(idx), k);
+    }
+
+    /*
+    * evaluate 0th to kmax^th derivatives of piecewise curve at parameter u.
+    * k^th column of the result is eval(u, k). The piece is located once.
+    */
+    MatrixDIMX evalDerivatives(T u, unsigned int kmax) const {
+        this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(u);
+        return this->evalPieceDerivatives(idx, u - this->pieceStart(idx), kmax);
+    }
+
+    /*
+    * evaluate the kth derivative of piecewise curve at each parameter in us.
+    * i^th column of the result is eval(us(i), k).
+    */
+    MatrixDIMX evalMany(const Vector& us, unsigned int k) const {
+        MatrixDIMX result(DIM, us.size());
+        this->evalMany(us, k, result);
+        return result;
+    }
+
+    /*
+    * Strided variant of evalMany. Writes the results to the columns of result,
+    * which must have us.size() columns.
+    *
+    * Parameters are checked once. If us is sorted, pieces are walked in order,
+    * otherwise the piece of each parameter is found by binary search.
+    * Consecutive parameters that fall into the same piece are evaluated
+    * together in the bernstein basis, see evalPieceBlock.
+    */
+    void evalMany(const StridedVector& us, unsigned int k,
+                  Eigen::Ref<MatrixDIMX> result) const {
         this->emptyPiecesCheck();
+        if(result.cols() != us.size()) {
+            throw std::domain_error(
+                std::string("result column count does not match parameter count. given ")
+                + std::to_string(result.cols())
+                + std::string(", required ")
+                + std::to_string(us.size())
+            );
+        }
+
+        if(us.size() == 0) {
+            return;
+        }
 
-        auto idx = std::lower_bound(m_cumulativeParameters.begin(), m_cumulativeParameters.end(), u)
-                   - m_cumulativeParameters.begin();
+        this->parameterBoundCheck(us.minCoeff());
+        this->parameterBoundCheck(us.maxCoeff());
 
+        bool sorted = true;
+        for(Index i = 1; i < us.size() && sorted; i++) {
+            sorted = us(i-1) <= us(i);
+        }
 
-        if(idx != 0)
-            u -= m_cumulativeParameters[idx-1];
+        // parameters blockStart to blockEnd - 1 are in piece idx
+        Vector localUs(us.size());
+        MatrixDIMX derivative;
+        Matrix basis;
+        auto evalBlock = [&](std::size_t idx, Index blockStart, Index blockEnd) {
+            auto localU = [&localUs, blockStart](Index i) {
+                return localUs(blockStart + i);
+            };
+            this->evalPieceBlock(idx, blockEnd - blockStart, localU, k,
+                                 result.middleCols(blockStart, blockEnd - blockStart),
+                                 derivative, basis);
+        };
 
-        return m_pieces[idx]->eval(
-                std::min(u, m_pieces[idx]->maxParameter()),
-                k
+        std::size_t idx = this->pieceIndex(us(0));
+        T start = this->pieceStart(idx);
+        T end = this->pieceEnd(idx);
+        Index blockStart = 0;
+        for(Index i = 0; i < us.size(); i++) {
+            std::size_t uidx = idx;
+            if(sorted) {
+                while(end < us(i)) {
+                    uidx++;
+                    start = end;
+                    end = this->pieceEnd(uidx);
+                }
+            } else {
+                uidx = this->pieceIndex(us(i));
+                if(uidx != idx) {
+                    start = this->pieceStart(uidx);
+                }
+            }
+
+            if(i != blockStart && uidx != idx) {
+                evalBlock(idx, blockStart, i);
+                blockStart = i;
+            }
+            idx = uidx;
+
+            localUs(i) = std::min(us(i) - start, m_durations[idx]);
+        }
+
+        evalBlock(idx, blockStart, us.size());
+    }
+
+    /*
+    * Cursor for evaluating the curve at non-decreasing parameters, e.g. when
+    * playing a trajectory back in time. It remembers the piece of the last
+    * query and its bounds, so queries in the same piece take O(1) and moving
+    * forward to a nearby piece takes O(1) per piece passed, since the end of
+    * the next piece is the running end plus its duration. Backward moves and
+    * long forward jumps fall back to an O(log n) search that resets the
+    * running bounds. Results agree with the ones of the curve up to rounding
+    * of the piece bounds.
+    *
+    * The cursor refers to the curve, which must outlive it. It must be reset
+    * if pieces of the curve are added or set.
+    */
+    class Cursor {
+    public:
+        explicit Cursor(const PiecewiseCurve& curve): m_curve(&curve) {
+            this->reset();
+        }
+
+        // evaluate the kth derivative of the curve at parameter u
+        VectorDIM eval(T u, unsigned int k) {
+            m_curve->parameterBoundCheck(u);
+            this->seek(u);
+            return m_curve->evalPiece(m_pieceIdx, u - m_pieceStart, k);
+        }
+
+        // evaluate 0th to kmax^th derivatives of the curve at parameter u
+        MatrixDIMX evalDerivatives(T u, unsigned int kmax) {
+            m_curve->parameterBoundCheck(u);
+            this->seek(u);
+            return m_curve->evalPieceDerivatives(m_pieceIdx, u - m_pieceStart, kmax);
+        }
+
+        // index of the piece of the last query
+        std::size_t pieceIndex() const {
+            return m_pieceIdx;
+        }
+
+        // move the cursor back to the first piece
+        void reset() {
+            m_pieceIdx = 0;
+            m_pieceStart = 0;
+            m_pieceEnd = m_curve->m_pieces.empty()
+                            ? T(0) : m_curve->pieceEnd(0);
+        }
+
+    private:
+        /*
+        * Number of pieces the cursor walks forward before falling back to
+        * binary search.
+        */
+        static constexpr std::size_t MAX_LINEAR_STEPS = 8;
+
+        const PiecewiseCurve* m_curve;
+        std::size_t m_pieceIdx;
+
+        /*
+        * piece m_pieceIdx is defined for parameters in
+        * (m_pieceStart, m_pieceEnd] of the curve
+        */
+        T m_pieceStart;
+        T m_pieceEnd;
+
+        // move the cursor to the piece that contains u
+        void seek(T u) {
+            if(m_pieceIdx >= m_curve->numPieces()
+                || (m_pieceIdx != 0 && m_pieceStart >= u)) {
+                this->jump(u);
+                return;
+            }
+
+            // the running end can round below the total duration, in which
+            // case the last piece is kept and the piece parameter is clamped
+            const std::size_t lastIdx = m_curve->numPieces() - 1;
+            for(std::size_t steps = 0;
+                m_pieceEnd < u && m_pieceIdx < lastIdx; steps++) {
+                if(steps == MAX_LINEAR_STEPS) {
+                    this->jump(u);
+                    return;
+                }
+                m_pieceIdx++;
+                m_pieceStart = m_pieceEnd;
+                m_pieceEnd += m_curve->m_durations[m_pieceIdx];
+            }
+        }
+
+        // move the cursor to the piece that contains u by search
+        void jump(T u) {
+            m_pieceIdx = m_curve->pieceIndex(u);
+            m_pieceStart = m_curve->pieceStart(m_pieceIdx);
+            m_pieceEnd = m_curve->pieceEnd(m_pieceIdx);
+        }
+    };
+
+    // get a cursor that starts at the first piece
+    Cursor cursor() const {
+        return Cursor(*this);
+    }
+
+    /*
+    * number of samples of sample(t0, t1, dt, kmax), i.e. number of
+    * parameters t0 + i * dt that are not greater than t1. t1 counts as a
+    * sample if it is a multiple of dt away from t0 up to rounding, e.g.
+    * for t0 = 0, t1 = 0.3 and dt = 0.1.
+    */
+    static Index numSamples(T t0, T t1, T dt) {
+        if(dt <= 0 || t1 < t0) {
+            throw std::domain_error(
+                std::string("sampling requires dt > 0 and t0 <= t1. given t0: ")
+                + std::to_string(t0)
+                + std::string(", t1: ")
+                + std::to_string(t1)
+                + std::string(", dt: ")
+                + std::to_string(dt)
+            );
+        }
+
+        // the quotient of a multiple of dt can round just below an integer
+        const T ratio = (t1 - t0) / dt;
+        const T tolerance = 16 * std::numeric_limits<T>::epsilon()
+                            * std::max<T>(1, ratio);
+        return static_cast<Index>(std::floor(ratio + tolerance)) + 1;
+    }
+
+    /*
+    * sample 0th to kmax^th derivatives of the curve at parameters
+    * t0, t0 + dt, ..., up to t1. Parameters are clamped to t1 to avoid
+    * rounding errors. Columns k * N to (k + 1) * N - 1 of the
+    * result are the k^th derivatives at the N = numSamples(t0, t1, dt)
+    * parameters.
+    */
+    MatrixDIMX sample(T t0, T t1, T dt, unsigned int kmax,
+                      unsigned int numThreads = 1) const {
+        MatrixDIMX result(DIM, numSamples(t0, t1, dt) * (kmax + 1));
+        this->sample(t0, t1, dt, kmax, result, numThreads);
+        return result;
+    }
+
+    /*
+    * Variant of sample that writes to result, which must have
+    * numSamples(t0, t1, dt) * (kmax + 1) columns.
+    *
+    * Pieces are walked in order. Samples of a piece are evaluated together
+    * as the product of the derivative control points of the piece and the
+    * bernstein basis of the sample parameters, one product per derivative. If
+    * numThreads > 1, samples are split into that many contiguous ranges
+    * that are evaluated in parallel.
+    */
+    void sample(T t0, T t1, T dt, unsigned int kmax,
+                Eigen::Ref<MatrixDIMX> result, unsigned int numThreads = 1) const {
+        const Index N = numSamples(t0, t1, dt);
+        if(result.cols() != N * (kmax + 1)) {
+            throw std::domain_error(
+                std::string("result column count does not match sample count. given ")
+                + std::to_string(result.cols())
+                + std::string(", required ")
+                + std::to_string(N * (kmax + 1))
+            );
+        }
+
+        this->parameterBoundCheck(t0);
+        this->parameterBoundCheck(t1);
+
+        const Index numRanges = std::max<Index>(1, std::min<Index>(numThreads, N));
+        if(numRanges == 1) {
+            this->sampleRange(t0, t1, dt, 0, N, N, kmax, result);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        for(Index r = 0; r < numRanges; r++) {
+            threads.emplace_back([this, t0, t1, dt, N, kmax, r, numRanges, &result]() {
+                this->sampleRange(t0, t1, dt, N * r / numRanges, N * (r + 1) / numRanges,
+                                  N, kmax, result);
+            });
+        }
+        for(auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    /*
+    * length of the curve from parameter 0 to parameter u.
+    *
+    * Arc length table of the curve is computed on the first arc length query
+    * and reused until the curve is modified. Each piece is split into
+    * ARC_LENGTH_SEGMENTS segments of equal duration whose lengths are
+    * computed with gauss-legendre quadrature, and the table holds the
+    * cumulative lengths of the segments. A query is a table lookup plus one
+    * quadrature over part of a segment. Since the table is filled lazily,
+    * concurrent calls on the same curve are not safe until it is filled,
+    * e.g. by buildCaches.
+    */
+    T arcLength(T u) const {
+        this->parameterBoundCheck(u);
+        const std::vector<T>& table = this->arcLengthTable();
+
+        const auto idx = this->pieceIndex(u);
+        const T duration = m_durations[idx];
+        const T local = ClampPolicy::apply(u - this->pieceStart(idx), duration);
+        const T h = duration / ARC_LENGTH_SEGMENTS;
+        const std::size_t j = h > 0 ? std::min<std::size_t>(
+            static_cast<std::size_t>(local / h), ARC_LENGTH_SEGMENTS - 1
+        ) : 0;
+        const std::size_t pos = idx * ARC_LENGTH_SEGMENTS + j;
+
+        return (pos == 0 ? T(0) : table[pos - 1])
+               + this->pieceArcLength(idx, j * h, local);
+    }
+
+    // length of the whole curve
+    T arcLength() const {
+        this->emptyPiecesCheck();
+        return this->arcLengthTable().back();
+    }
+
+    /*
+    * parameter u where arcLength(u) = s. The segment that contains s is
+    * found in the arc length table, then u is refined with newton's method
+    * safeguarded by bisection. If the curve stops on an interval, the first
+    * parameter with length s is not guaranteed.
+    *
+    * @fails if s is outside [0, arcLength()]
+    */
+    T parameterAtArcLength(T s) const {
+        this->emptyPiecesCheck();
+        const std::vector<T>& table = this->arcLengthTable();
+        if(s < 0 || s > table.back()) {
+            throw std::domain_error(
+                std::string("given arc length is out of bounds. given s: ")
+                + std::to_string(s)
+                + std::string(", allowed range: [0, ")
+                + std::to_string(table.back())
+                + std::string("]")
+            );
+        }
+
+        const std::size_t pos = std::min<std::size_t>(
+            std::lower_bound(table.begin(), table.end(), s) - table.begin(),
+            table.size() - 1
         );
+        const std::size_t idx = pos / ARC_LENGTH_SEGMENTS;
+        const std::size_t j = pos % ARC_LENGTH_SEGMENTS;
+        const T h = m_durations[idx] / ARC_LENGTH_SEGMENTS;
+        const T segmentStart = j * h;
+        const T base = (pos == 0 ? T(0) : table[pos - 1]);
+        const T segmentLength = table[pos] - base;
+        const T target = s - base;
+        if(segmentLength <= 0) {
+            return this->pieceStart(idx) + segmentStart;
+        }
+
+        const T tolerance = std::numeric_limits<T>::epsilon() * 16
+                            * std::max(T(1), table.back());
+        T lo = segmentStart, hi = segmentStart + h;
+        T u = segmentStart + h * (target / segmentLength);
+        for(unsigned int iter = 0; iter < ARC_LENGTH_MAX_ITERATIONS; iter++) {
+            const T error = this->pieceArcLength(idx, segmentStart, u) - target;
+            if(std::abs(error) <= tolerance) {
+                break;
+            }
+
+            if(error > 0) {
+                hi = u;
+            } else {
+                lo = u;
+            }
+
+            const T speed = this->evalPiece(idx, u, 1).norm();
+            T next = (speed > 0 ? u - error / speed : lo);
+            if(!(next > lo && next < hi)) {
+                next = (lo + hi) / 2;
+            }
+            u = next;
+        }
+
+        return this->pieceStart(idx) + u;
+    }
+
+    /*
+    * parameterAtArcLength for each arc length in ss. i^th element of the
+    * result is parameterAtArcLength(ss(i)).
+    */
+    Vector parametersAtArcLengths(const Vector& ss) const {
+        Vector result(ss.size());
+        for(Index i = 0; i < ss.size(); i++) {
+            result(i) = this->parameterAtArcLength(ss(i));
+        }
+        return result;
     }
 
     T maxParameter() const {
         this->emptyPiecesCheck();
-        return m_cumulativeParameters.back();
+        return this->totalDuration();
     }
 
 private:
-    std::vector<std::shared_ptr<_ParametricCurve>> m_pieces;
-    std::vector<T> m_cumulativeParameters;
+    /*
+    * A piece is the bezier curve whose control points are
+    * m_controlPoints[offset, offset + numControlPoints)
+    */
+    struct Piece {
+        std::size_t offset;
+        std::size_t numControlPoints;
+    };
 
-    void addNewCurveMaxParameter(T maxParam) {
-        if(m_cumulativeParameters.empty()) {
-            m_cumulativeParameters.push_back(maxParam);
-        } else {
-            m_cumulativeParameters.push_back(m_cumulativeParameters.back() + maxParam);
+    /*
+    * Control points of all pieces, stored back to back in piece order.
+    */
+    ControlPoints m_controlPoints;
+    std::vector<Piece> m_pieces;
+
+    /*
+    * m_durations[i] is the max parameter of piece i. Prefix sums give the
+    * parameters where pieces end.
+    */
+    splx::internal::FenwickTree<T> m_durations;
+
+    /*
+    * Number of pieces for each distinct max parameter, so that uniformity is
+    * kept up to date in O(log n) when a piece is retimed.
+    */
+    std::map<T, std::size_t> m_durationCounts;
+
+    /*
+    * Number of segments per piece in the arc length table
+    */
+    static constexpr std::size_t ARC_LENGTH_SEGMENTS = 8;
+
+    /*
+    * Maximum number of newton iterations of parameterAtArcLength
+    */
+    static constexpr unsigned int ARC_LENGTH_MAX_ITERATIONS = 32;
+
+    /*
+    * m_arcLengths[i * ARC_LENGTH_SEGMENTS + j] is the length of the curve
+    * from parameter 0 to the end of segment j of piece i. Empty if not
+    * computed yet. Cleared whenever the curve is modified.
+    */
+    mutable std::vector<T> m_arcLengths;
+
+    using AlignedBoxes = std::vector<AlignedBox, Eigen::aligned_allocator<AlignedBox>>;
+
+    /*
+    * m_boundingBoxes[i] is the bounding box of the control points of
+    * piece i
+    */
+    AlignedBoxes m_boundingBoxes;
+
+    /*
+    * Bounding volume hierarchy over pieces as a complete binary tree. Node 1
+    * is the root, children of node i are 2i and 2i + 1, and node L + i is
+    * piece i where L is the smallest power of 2 not less than the number of
+    * pieces. Each node is the union of its children. Empty if not built
+    * yet. Cleared whenever a piece is added.
+    */
+    mutable AlignedBoxes m_boundingVolumes;
+
+    // returns the bounding volume hierarchy, building it if it is not built
+    const AlignedBoxes& boundingVolumes() const {
+        if(m_boundingVolumes.empty() && !m_pieces.empty()) {
+            std::size_t numLeaves = 1;
+            while(numLeaves < m_pieces.size()) {
+                numLeaves *= 2;
+            }
+
+            m_boundingVolumes.assign(2 * numLeaves, AlignedBox());
+            for(std::size_t i = 0; i < m_pieces.size(); i++) {
+                m_boundingVolumes[numLeaves + i] = m_boundingBoxes[i];
+            }
+            for(std::size_t node = numLeaves - 1; node > 0; node--) {
+                m_boundingVolumes[node] = m_boundingVolumes[2 * node].merged(
+                    m_boundingVolumes[2 * node + 1]
+                );
+            }
         }
+
+        return m_boundingVolumes;
     }
 
-    void fixCumulativeParameters(std::size_t idx) {
-        for(; idx < m_cumulativeParameters.size(); idx++) {
-            if(idx == 0) {
-                m_cumulativeParameters[idx] = m_pieces[idx]->maxParameter();
+    // updates the ancestors of piece idx if the hierarchy is built
+    void refitBoundingVolumes(std::size_t idx) {
+        if(m_boundingVolumes.empty()) {
+            return;
+        }
+
+        std::size_t node = m_boundingVolumes.size() / 2 + idx;
+        m_boundingVolumes[node] = m_boundingBoxes[idx];
+        for(node /= 2; node > 0; node /= 2) {
+            m_boundingVolumes[node] = m_boundingVolumes[2 * node].merged(
+                m_boundingVolumes[2 * node + 1]
+            );
+        }
+    }
+
+    /*
+    * indices of the pieces whose bounding boxes satisfy overlaps, in
+    * increasing order. overlaps must be true for a node if it is true for
+    * any of its pieces.
+    */
+    template<typename Overlaps>
+    std::vector<std::size_t> queryBoundingVolumes(const Overlaps& overlaps) const {
+        std::vector<std::size_t> result;
+        const AlignedBoxes& volumes = this->boundingVolumes();
+        if(volumes.empty()) {
+            return result;
+        }
+
+        const std::size_t numLeaves = volumes.size() / 2;
+        std::vector<std::size_t> stack{1};
+        while(!stack.empty()) {
+            const std::size_t node = stack.back();
+            stack.pop_back();
+            if(!overlaps(volumes[node])) {
+                continue;
+            }
+
+            if(node >= numLeaves) {
+                result.push_back(node - numLeaves);
             } else {
-                m_cumulativeParameters[idx] = m_cumulativeParameters[idx-1] + m_pieces[idx]->maxParameter();
+                stack.push_back(2 * node + 1);
+                stack.push_back(2 * node);
+            }
+        }
+
+        return result;
+    }
+
+    void invalidateCaches() {
+        m_arcLengths.clear();
+    }
+
+    // returns the arc length table, computing it if it is not cached
+    const std::vector<T>& arcLengthTable() const {
+        if(m_arcLengths.empty() && !m_pieces.empty()) {
+            m_arcLengths.resize(m_pieces.size() * ARC_LENGTH_SEGMENTS);
+            T length = 0;
+            for(std::size_t i = 0; i < m_pieces.size(); i++) {
+                const T h = m_durations[i] / ARC_LENGTH_SEGMENTS;
+                for(std::size_t j = 0; j < ARC_LENGTH_SEGMENTS; j++) {
+                    length += this->pieceArcLength(i, j * h, (j + 1) * h);
+                    m_arcLengths[i * ARC_LENGTH_SEGMENTS + j] = length;
+                }
             }
         }
+
+        return m_arcLengths;
+    }
+
+    // length of piece idx between its parameters u0 and u1
+    T pieceArcLength(std::size_t idx, T u0, T u1) const {
+        return splx::internal::gaussLegendre(
+            [this, idx](T u) { return this->evalPiece(idx, u, 1).norm(); },
+            u0, u1
+        );
+    }
+
+    void pushDuration(T duration) {
+        m_durations.push_back(duration);
+        m_durationCounts[duration]++;
+    }
+
+    void setDuration(std::size_t idx, T duration) {
+        auto it = m_durationCounts.find(m_durations[idx]);
+        if(--it->second == 0) {
+            m_durationCounts.erase(it);
+        }
+        m_durationCounts[duration]++;
+        m_durations.set(idx, duration);
+    }
+
+    // true if pieces can be found by division
+    bool uniformLookup() const noexcept {
+        return m_durationCounts.size() == 1
+                && m_durations[0] > 0;
+    }
+
+    // index of the piece that contains parameter u
+    std::size_t pieceIndex(T u) const noexcept {
+        if(!this->uniformLookup()) {
+            return m_durations.lowerBound(u);
+        }
+
+        // smallest idx with pieceEnd(idx) >= u. the estimate is corrected
+        // so that results agree with pieceEnd under rounding
+        const T estimate = std::ceil(u / m_durations[0]) - 1;
+        std::size_t idx = estimate <= 0 ? 0 : std::min(
+            static_cast<std::size_t>(estimate), m_durations.size()
+        );
+        while(idx < m_durations.size() && this->pieceEnd(idx) < u) {
+            idx++;
+        }
+        while(idx > 0 && this->pieceEnd(idx - 1) >= u) {
+            idx--;
+        }
+        return idx;
+    }
+
+    // parameter of the piecewise curve where piece idx ends
+    T pieceEnd(std::size_t idx) const noexcept {
+        if(this->uniformLookup()) {
+            return (idx + 1) * m_durations[0];
+        }
+        return m_durations.prefixSum(idx);
+    }
+
+    // parameter of the piecewise curve where piece idx starts
+    T pieceStart(std::size_t idx) const noexcept {
+        return idx == 0 ? T(0) : this->pieceEnd(idx - 1);
+    }
+
+    // max parameter of the piecewise curve, 0 if there are no pieces
+    T totalDuration() const noexcept {
+        return m_durations.empty() ? T(0) : this->pieceEnd(m_durations.size() - 1);
+    }
+
+    // control points of piece idx as columns of a matrix
+    Eigen::Map<const MatrixDIMX> controlPointMatrix(std::size_t idx) const noexcept {
+        return Eigen::Map<const MatrixDIMX>(
+            m_pieces[idx].numControlPoints == 0
+                ? nullptr : m_controlPoints[m_pieces[idx].offset].data(),
+            DIM,
+            m_pieces[idx].numControlPoints
+        );
+    }
+
+    /*
+    * evaluate the kth derivative of piece idx at parameter u of the piece.
+    * u is clamped to the piece.
+    */
+    VectorDIM evalPiece(std::size_t idx, T u, unsigned int k) const noexcept {
+        return splx::internal::bezier::evalHorner(
+                this->controlPointMatrix(idx),
+                m_durations[idx],
+                ClampPolicy::apply(u, m_durations[idx]),
+                k
+        );
+    }
+
+    /*
+    * evaluate 0th to kmax^th derivatives of piece idx at parameter u of the
+    * piece. u is clamped to the piece.
+    */
+    MatrixDIMX evalPieceDerivatives(std::size_t idx, T u, unsigned int kmax) const {
+        MatrixDIMX result(DIM, kmax + 1);
+        MatrixDIMX work(DIM, m_pieces[idx].numControlPoints);
+        splx::internal::bezier::evalDerivatives(
+            this->controlPointMatrix(idx), m_durations[idx],
+            ClampPolicy::apply(u, m_durations[idx]), kmax, work, result
+        );
+        return result;
+    }
+
+    /*
+    * evaluate samples i0 to i1 - 1 of sample(t0, t1, dt, kmax), which has N
+    * samples, and write them to their columns of result
+    */
+    void sampleRange(T t0, T t1, T dt, Index i0, Index i1, Index N, unsigned int kmax,
+                     Eigen::Ref<MatrixDIMX> result) const {
+        auto param = [t0, t1, dt](Index i) {
+            return std::min(t0 + i * dt, t1);
+        };
+
+        // workspaces shared by the pieces of the range
+        MatrixDIMX derivative;
+        Matrix basis;
+
+        Index blockStart = i0;
+        std::size_t idx = this->pieceIndex(param(i0));
+        while(blockStart < i1) {
+            // samples blockStart to blockEnd - 1 are in piece idx
+            const T end = this->pieceEnd(idx);
+            Index blockEnd = blockStart + 1;
+            while(blockEnd < i1 && param(blockEnd) <= end) {
+                blockEnd++;
+            }
+
+            const Index m = blockEnd - blockStart;
+            const T start = this->pieceStart(idx);
+            auto localU = [&param, blockStart, start](Index i) {
+                return param(blockStart + i) - start;
+            };
+            for(unsigned int k = 0; k <= kmax; k++) {
+                this->evalPieceBlock(idx, m, localU, k,
+                                     result.middleCols(k * N + blockStart, m),
+                                     derivative, basis);
+            }
+
+            blockStart = blockEnd;
+            idx++;
+            while(blockStart < i1 && idx < m_pieces.size()
+                    && this->pieceEnd(idx) < param(blockStart)) {
+                idx++;
+            }
+            idx = std::min(idx, m_pieces.size() - 1);
+        }
+    }
+
+    /*
+    * evaluate the kth derivative of piece idx at the m local parameters
+    * localU(0) to localU(m - 1) and write them to the columns of result.
+    * Local parameters are clamped to the piece.
+    *
+    * The control points of the kth derivative are multiplied with the
+    * bernstein basis of t = u / a of all parameters at once. Unlike the
+    * power basis in raw u, this stays accurate at high degrees.
+    * derivative and basis are workspaces that grow as needed, so that
+    * pieces evaluated one after another share them.
+    */
+    template<typename LocalU>
+    void evalPieceBlock(std::size_t idx, Index m, const LocalU& localU, unsigned int k,
+                        Eigen::Ref<MatrixDIMX> result,
+                        MatrixDIMX& derivative, Matrix& basis) const {
+        const Index numControlPoints = m_pieces[idx].numControlPoints;
+        const T duration = m_durations[idx];
+        if(numControlPoints == 0 || static_cast<Index>(k) >= numControlPoints) {
+            result.setZero();
+            return;
+        }
+
+        if(duration == 0) {
+            for(Index i = 0; i < m; i++) {
+                result.col(i) = this->evalPiece(idx, 0, k);
+            }
+            return;
+        }
+
+        const Index hodographSize = numControlPoints - k;
+        if(derivative.cols() < numControlPoints) {
+            derivative.resize(DIM, numControlPoints);
+        }
+        if(basis.rows() < hodographSize || basis.cols() < m) {
+            basis.resize(std::max(basis.rows(), hodographSize),
+                         std::max(basis.cols(), m));
+        }
+
+        splx::internal::bezier::derivativeControlPoints(
+            this->controlPointMatrix(idx), duration, k, derivative
+        );
+        for(Index i = 0; i < m; i++) {
+            const T u = ClampPolicy::apply(localU(i), duration);
+            splx::internal::bezier::fillBernsteinBasis(
+                hodographSize - 1, u / duration,
+                basis.col(i).head(hodographSize)
+            );
+        }
+
+        result.noalias() = derivative.leftCols(hodographSize)
+                         * basis.topLeftCorner(hodographSize, m);
+    }
+
+    // returns the given piece as a bezier, fails if it is not a bezier
+    static const _Bezier& asBezier(const _ParametricCurve& piece) {
+        if(piece.type != CurveType::BEZIER) {
+            throw std::domain_error(
+                std::string("piecewise curve only supports bezier pieces")
+            );
+        }
+
+        return static_cast<const _Bezier&>(piece);
     }
 
     void pieceIndexCheck(std::size_t idx) const { // checks if piece index is valid
-        if(idx >= m_cumulativeParameters.size() || idx < 0) {
+        if(idx >= m_pieces.size()) {
             throw std::domain_error(
                 std::string("piece index used is ")
                 + std::to_string(idx)
                 + std::string(" while piece count is ")
-                + std::to_string(m_cumulativeParameters.size())
+                + std::to_string(m_pieces.size())
             );
         }
     }
 
     void emptyPiecesCheck() const { // checks if there is at least one piece.
-        if(m_cumulativeParameters.empty()) {
+        if(m_pieces.empty()) {
             throw std::logic_error(
                 std::string("piecewise curve is empty.")
             );
@@ -178,12 +1219,13 @@ private:
 
     void parameterBoundCheck(T u) const { // checks if given parameter is valid
         this->emptyPiecesCheck();
-        if(u < 0 || u > m_cumulativeParameters.back()) {
+        const T maxParam = this->totalDuration();
+        if(u < 0 || u > maxParam) {
             throw std::domain_error(
                 std::string("given parameter is out of bounds. given u: ")
                 + std::to_string(u)
                 + std::string(", allowed range: [0, ")
-                + std::to_string(m_cumulativeParameters.back())
+                + std::to_string(maxParam)
                 + std::string("]")
             );
         }
@@ -0,0 +1,296 @@
+#ifndef SPLX_PIECEWISECURVEVIEW_HPP
+#define SPLX_PIECEWISECURVEVIEW_HPP
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <splx/curve/ParametricCurve.hpp>
+#include <splx/curve/PiecewiseCurve.hpp>
+#include <splx/internal/bezier.hpp>
+#include <splx/io/binary.hpp>
+#include <splx/policies.hpp>
+
+namespace splx {
+
+/*
+* Read only piecewise bezier curve over a buffer in the binary layout of
+* splx/io/binary.hpp, e.g. a memory mapped file. Control points and
+* durations are read in place and never copied. Constructing a view takes
+* O(n) time to validate the piece table, durations and ends, so that
+* queries never read outside the buffer. The buffer must outlive the view.
+*/
+template<typename T, unsigned int DIM>
+class PiecewiseCurveView {
+public:
+    using _PiecewiseCurve = PiecewiseCurve<T, DIM>;
+    using _Bezier = splx::Bezier<T, DIM>;
+    using VectorDIM = typename _PiecewiseCurve::VectorDIM;
+    using MatrixDIMX = typename _PiecewiseCurve::MatrixDIMX;
+    using ControlPoints = typename _PiecewiseCurve::ControlPoints;
+
+    /*
+    * Creates a view over size bytes at data. Fails if data is not aligned
+    * to both the scalar type and the piece table, or the buffer is not a
+    * valid curve with scalar T and dimension DIM in the current version of
+    * the layout and in the byte order of this machine.
+    */
+    PiecewiseCurveView(const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        constexpr std::size_t alignment = std::max(alignof(T), alignof(io::BinaryPiece));
+        if(reinterpret_cast<std::uintptr_t>(data) % alignment != 0) {
+            throw std::domain_error(
+                std::string("buffer is not aligned to ")
+                + std::to_string(alignment)
+                + std::string(" bytes")
+            );
+        }
+
+        if(size < sizeof(io::BinaryHeader)) {
+            throw std::domain_error(
+                std::string("buffer is smaller than the binary header")
+            );
+        }
+
+        io::BinaryHeader header;
+        std::memcpy(&header, bytes, sizeof(io::BinaryHeader));
+        if(std::memcmp(header.magic, io::BINARY_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::domain_error(
+                std::string("buffer is not a splx piecewise curve")
+            );
+        }
+
+        if(header.version != io::BINARY_VERSION) {
+            throw std::domain_error(
+                std::string("unsupported binary version. given ")
+                + std::to_string(header.version)
+                + std::string(", supported ")
+                + std::to_string(io::BINARY_VERSION)
+            );
+        }
+
+        if(header.byteOrder != io::BINARY_BYTE_ORDER) {
+            throw std::domain_error(
+                std::string("buffer is written in a different byte order")
+            );
+        }
+
+        if(header.scalarSize != sizeof(T) || header.dimension != DIM) {
+            throw std::domain_error(
+                std::string("scalar size or dimension does not match. given scalar size ")
+                + std::to_string(header.scalarSize)
+                + std::string(", dimension ")
+                + std::to_string(header.dimension)
+            );
+        }
+
+        const io::BinaryHeader expected = io::internal::makeHeader<T, DIM>(
+            header.numPieces, header.numControlPoints
+        );
+        if(header.pieceTableOffset != expected.pieceTableOffset
+            || header.durationsOffset != expected.durationsOffset
+            || header.endsOffset != expected.endsOffset
+            || header.controlPointsOffset != expected.controlPointsOffset
+            || header.size != expected.size
+            || size < header.size) {
+            throw std::domain_error(
+                std::string("binary layout is corrupted or truncated")
+            );
+        }
+
+        m_numPieces = header.numPieces;
+        m_pieces = reinterpret_cast<const io::BinaryPiece*>(bytes + header.pieceTableOffset);
+        m_durations = reinterpret_cast<const T*>(bytes + header.durationsOffset);
+        m_ends = reinterpret_cast<const T*>(bytes + header.endsOffset);
+        m_controlPoints = reinterpret_cast<const T*>(bytes + header.controlPointsOffset);
+        this->pieceTableCheck(header.numControlPoints);
+    }
+
+    // get number of pieces
+    std::size_t numPieces() const {
+        return m_numPieces;
+    }
+
+    T maxParameter() const {
+        this->emptyPiecesCheck();
+        return m_ends[m_numPieces - 1];
+    }
+
+    // get the max parameter of the piece with given index
+    T pieceMaxParameter(std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return m_durations[idx];
+    }
+
+    /*
+    * View of the control points of the piece with given index as a
+    * DIM x numControlPoints matrix. Does not copy.
+    */
+    Eigen::Map<const MatrixDIMX> pieceControlPoints(std::size_t idx) const {
+        this->pieceIndexCheck(idx);
+        return this->controlPointMatrix(idx);
+    }
+
+    // evaluate the kth derivative at piecewise curve at parameter u
+    VectorDIM eval(T u, unsigned int k) const {
+        this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(u);
+        return this->evalPiece(idx, u - this->pieceStart(idx), k);
+    }
+
+    /*
+    * evaluate the kth derivative of piecewise curve at parameter u for
+    * real time use. u is mapped to [0, maxParameter()] with Policy
+    * (ClampPolicy, WrapPolicy or AssertPolicy). Never allocates or throws.
+    * Returns zero for an empty curve.
+    */
+    template<typename Policy>
+    VectorDIM eval(T u, unsigned int k) const noexcept {
+        if(m_numPieces == 0) {
+            return VectorDIM::Zero();
+        }
+
+        u = Policy::apply(u, m_ends[m_numPieces - 1]);
+        auto idx = std::min(this->pieceIndex(u), m_numPieces - 1);
+        return this->evalPiece(idx, u - this->pieceStart(idx), k);
+    }
+
+    /*
+    * evaluate 0th to kmax^th derivatives of piecewise curve at parameter u.
+    * k^th column of the result is eval(u, k).
+    */
+    MatrixDIMX evalDerivatives(T u, unsigned int kmax) const {
+        this->parameterBoundCheck(u);
+        auto idx = this->pieceIndex(u);
+
+        MatrixDIMX result(DIM, kmax + 1);
+        MatrixDIMX work(DIM, m_pieces[idx].numControlPoints);
+        splx::internal::bezier::evalDerivatives(
+            this->controlPointMatrix(idx), m_durations[idx],
+            ClampPolicy::apply(u - this->pieceStart(idx), m_durations[idx]),
+            kmax, work, result
+        );
+        return result;
+    }
+
+    // copy the curve to a PiecewiseCurve
+    _PiecewiseCurve toPiecewiseCurve() const {
+        _PiecewiseCurve curve;
+        for(std::size_t i = 0; i < m_numPieces; i++) {
+            const auto cpts = this->controlPointMatrix(i);
+            ControlPoints points;
+            for(Index j = 0; j < cpts.cols(); j++) {
+                points.push_back(cpts.col(j));
+            }
+            curve.addPiece(_Bezier(m_durations[i], points));
+        }
+        return curve;
+    }
+
+private:
+    std::size_t m_numPieces;
+    const io::BinaryPiece* m_pieces;
+    const T* m_durations;
+    const T* m_ends;
+    const T* m_controlPoints;
+
+    // index of the piece that contains parameter u
+    std::size_t pieceIndex(T u) const noexcept {
+        return std::lower_bound(m_ends, m_ends + m_numPieces, u) - m_ends;
+    }
+
+    // parameter of the piecewise curve where piece idx starts
+    T pieceStart(std::size_t idx) const noexcept {
+        return idx == 0 ? T(0) : m_ends[idx - 1];
+    }
+
+    // control points of piece idx as columns of a matrix
+    Eigen::Map<const MatrixDIMX> controlPointMatrix(std::size_t idx) const noexcept {
+        return Eigen::Map<const MatrixDIMX>(
+            m_pieces[idx].numControlPoints == 0
+                ? nullptr : m_controlPoints + m_pieces[idx].offset * DIM,
+            DIM,
+            m_pieces[idx].numControlPoints
+        );
+    }
+
+    /*
+    * evaluate the kth derivative of piece idx at parameter u of the piece.
+    * u is clamped to the piece.
+    */
+    VectorDIM evalPiece(std::size_t idx, T u, unsigned int k) const noexcept {
+        return splx::internal::bezier::evalHorner(
+                this->controlPointMatrix(idx),
+                m_durations[idx],
+                ClampPolicy::apply(u, m_durations[idx]),
+                k
+        );
+    }
+
+    void pieceIndexCheck(std::size_t idx) const { // checks if piece index is valid
+        if(idx >= m_numPieces) {
+            throw std::domain_error(
+                std::string("piece index used is ")
+                + std::to_string(idx)
+                + std::string(" while piece count is ")
+                + std::to_string(m_numPieces)
+            );
+        }
+    }
+
+    /*
+    * checks if the control points of each piece are in the control point
+    * section, and durations and ends are finite, non negative and ends are
+    * non decreasing
+    */
+    void pieceTableCheck(std::uint64_t numControlPoints) const {
+        T end = 0;
+        for(std::size_t i = 0; i < m_numPieces; i++) {
+            const io::BinaryPiece& piece = m_pieces[i];
+            if(piece.offset > numControlPoints
+                || piece.numControlPoints > numControlPoints - piece.offset) {
+                throw std::domain_error(
+                    std::string("control points of piece ")
+                    + std::to_string(i)
+                    + std::string(" are out of the control point section")
+                );
+            }
+
+            if(!std::isfinite(m_durations[i]) || m_durations[i] < 0
+                || !std::isfinite(m_ends[i]) || m_ends[i] < end) {
+                throw std::domain_error(
+                    std::string("duration or end of piece ")
+                    + std::to_string(i)
+                    + std::string(" is not finite or not monotone")
+                );
+            }
+            end = m_ends[i];
+        }
+    }
+
+    void emptyPiecesCheck() const { // checks if there is at least one piece.
+        if(m_numPieces == 0) {
+            throw std::logic_error(
+                std::string("piecewise curve is empty.")
+            );
+        }
+    }
+
+    void parameterBoundCheck(T u) const { // checks if given parameter is valid
+        this->emptyPiecesCheck();
+        if(u < 0 || u > m_ends[m_numPieces - 1]) {
+            throw std::domain_error(
+                std::string("given parameter is out of bounds. given u: ")
+                + std::to_string(u)
+                + std::string(", allowed range: [0, ")
+                + std::to_string(m_ends[m_numPieces - 1])
+                + std::string("]")
+            );
+        }
+    }
+};
+
+} // namespace splx
+
+#endif
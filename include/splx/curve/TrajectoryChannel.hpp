@@ -0,0 +1,106 @@
+#ifndef SPLX_TRAJECTORYCHANNEL_HPP
+#define SPLX_TRAJECTORYCHANNEL_HPP
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <splx/curve/PiecewiseCurve.hpp>
+
+namespace splx {
+
+/*
+* Publishes curves from one writer thread, e.g. a planner, to one reader
+* thread, e.g. a controller, without locks and without copying control
+* points.
+*
+* Published curves are immutable snapshots held by shared pointers in a
+* triple buffer. publish and read each do a single atomic exchange, so
+* both are wait-free. The reader never copies or releases a snapshot, so
+* reading does not allocate, free or touch reference counts. Snapshots that
+* are no longer used are released by the writer on later publish calls.
+*
+* PiecewiseCurve fills its arc length table and bounding volume hierarchy
+* on the first query that needs them, so publish builds both before the
+* snapshot is visible to the reader. Snapshots are then only read by both
+* threads and can be queried by the writer and the reader concurrently.
+*/
+template<typename T, unsigned int DIM>
+class TrajectoryChannel {
+public:
+    using _PiecewiseCurve = PiecewiseCurve<T, DIM>;
+    using Snapshot = std::shared_ptr<const _PiecewiseCurve>;
+
+    TrajectoryChannel(): m_middle(1), m_back(0), m_front(2) {
+
+    }
+
+    TrajectoryChannel(const TrajectoryChannel&) = delete;
+    TrajectoryChannel& operator=(const TrajectoryChannel&) = delete;
+
+    /*
+    * Publishes the curve by moving it into a new snapshot. Writer side.
+    */
+    void publish(_PiecewiseCurve&& curve) {
+        this->publish(std::make_shared<const _PiecewiseCurve>(std::move(curve)));
+    }
+
+    /*
+    * Publishes the given snapshot. Writer side. Builds the caches of the
+    * snapshot, and releases the snapshot that was published two calls ago
+    * if the reader did not take it.
+    */
+    void publish(Snapshot snapshot) {
+        if(snapshot != nullptr) {
+            snapshot->buildCaches();
+        }
+
+        m_slots[m_back] = std::move(snapshot);
+        const std::uint8_t previous = m_middle.exchange(
+            m_back | DIRTY, std::memory_order_acq_rel
+        );
+        m_back = previous & INDEX;
+    }
+
+    /*
+    * Returns the latest published snapshot, nullptr if nothing is published
+    * yet. Reader side. The reference is valid until the next call to read.
+    */
+    const Snapshot& read() noexcept {
+        if(m_middle.load(std::memory_order_relaxed) & DIRTY) {
+            const std::uint8_t previous = m_middle.exchange(
+                m_front, std::memory_order_acq_rel
+            );
+            m_front = previous & INDEX;
+        }
+        return m_slots[m_front];
+    }
+
+    /*
+    * Returns true if a snapshot is published after the last read.
+    */
+    bool hasUpdate() const noexcept {
+        return m_middle.load(std::memory_order_relaxed) & DIRTY;
+    }
+
+private:
+    static constexpr std::uint8_t INDEX = 3;
+    static constexpr std::uint8_t DIRTY = 4;
+
+    Snapshot m_slots[3];
+
+    /*
+    * Slot that is passed between the writer and the reader. DIRTY bit is
+    * set if it is published but not read yet.
+    */
+    std::atomic<std::uint8_t> m_middle;
+
+    // slot owned by the writer
+    std::uint8_t m_back;
+
+    // slot owned by the reader
+    std::uint8_t m_front;
+};
+
+} // namespace splx
+
+#endif
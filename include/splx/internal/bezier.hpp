@@ -1,13 +1,62 @@
 #ifndef SPLX_INTERNAL_BEZIER_H
 #define SPLX_INTERNAL_BEZIER_H
 #include <Eigen/Dense>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <splx/types.hpp>
 #include <splx/internal/combinatorics.hpp>
+#include <splx/policies.hpp>
 
 namespace splx {
 namespace internal {
 namespace bezier {
 
+/*
+* given a bezier curve degree and max parameter, fill row r so that
+* multiplying the row with control points gives the kth derivative
+* of the curve at u. r must have degree + 1 columns.
+*
+* does not check whether u is in [0, maxParameter]. used to evaluate
+* many parameters while reusing the same row as workspace.
+*/
+template<typename T>
+void fillBasisRow(unsigned int degree, T maxParameter, T u, unsigned int k,
+                  Eigen::Ref<Row<T>> result) noexcept {
+    if(maxParameter == 0) {
+        result.setZero();
+        if(k == 0 && degree >= 0) {
+            result(0) = 1.0;
+        }
+        return;
+    }
+
+    T oneOverA = 1/maxParameter;
+    T oneOverAPowk = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        oneOverAPowk *= oneOverA;
+    }
+
+    for(unsigned int i = 0; i <= degree; i++) {
+    T base = 0.0;
+    T mult = 1.0;
+    T oneOverAPowjk = oneOverAPowk;
+    for(unsigned int j = 0; j+k <= degree; j++, mult *= u, oneOverAPowjk *= oneOverA) {
+        if(j+k >= i) {
+        // base += pow(oneOverA, i) * this->comb(degree-i, j+k-i)
+        //       * pow(-oneOverA, j+k-i) * this->perm(j+k, k)
+        //       * mult;
+
+        base += splx::internal::binomial<T>(degree-i, j+k-i)
+            * oneOverAPowjk * splx::internal::fallingFactorial<T>(j+k, k)
+            * mult * ((j+k-i)%2 == 0 ? 1 : -1);
+        }
+    }
+    base *= splx::internal::binomial<T>(degree, i);
+    result(i) = base;
+    }
+}
+
 /*
 * given a bezier curve degree and max parameter, return row r so that
 * multiplying the row with control points gives the kth derivative
@@ -26,36 +75,218 @@ Row<T> getBasisRow(unsigned int degree, T maxParameter, T u, unsigned int k) {
     );
     }
 
+    Row<T> result(degree + 1);
+    fillBasisRow<T>(degree, maxParameter, u, k, result);
+    return result;
+}
+
+/*
+* noexcept variant of getBasisRow that writes the row to result, which must
+* have degree + 1 columns. u is mapped to [0, maxParameter] with Policy.
+* does not allocate.
+*/
+template<typename Policy, typename T>
+void getBasisRow(unsigned int degree, T maxParameter, T u, unsigned int k,
+                 Row<T>& result) noexcept {
+    fillBasisRow<T>(degree, maxParameter, Policy::apply(u, maxParameter), k, result);
+}
+
+/*
+* evaluate the kth derivative of the bezier curve whose control points are
+* the columns of cpts and that is defined for u \in [0, maxParameter].
+*
+* control points of the kth derivative curve of degree d-k are
+* q_j = d!/(d-k)! / maxParameter^k * \sum_{i=0}^k (-1)^(k-i) C(k, i) p_{j+i}
+* they are computed on the fly and summed with horner's scheme for
+* bernstein polynomials. takes O((d-k+1)(k+1)) operations, does not call pow
+* and does not allocate.
+*
+* does not check whether u is in [0, maxParameter].
+*/
+template<typename Derived>
+Eigen::Matrix<typename Derived::Scalar, Derived::RowsAtCompileTime, 1>
+evalHorner(const Eigen::MatrixBase<Derived>& cpts,
+           typename Derived::Scalar maxParameter,
+           typename Derived::Scalar u,
+           unsigned int k) {
+    using T = typename Derived::Scalar;
+    using VectorDIM = Eigen::Matrix<T, Derived::RowsAtCompileTime, 1>;
+
+    VectorDIM result(cpts.rows());
+    result.setZero();
+
+    const Index numControlPoints = cpts.cols();
+    if(numControlPoints == 0 || static_cast<Index>(k) >= numControlPoints) {
+        return result;
+    }
+
     if(maxParameter == 0) {
-        Row<T> result(degree+1);
-        result.setZero();
-        if(k == 0 && degree >= 0) {
-            result(0) = 1.0;
+        if(k == 0) {
+            result = cpts.col(0);
         }
         return result;
     }
 
-    Row<T> result(degree + 1);
+    const unsigned int degree = numControlPoints - 1;
+    const unsigned int hodographDegree = degree - k;
 
-    T oneOverA = 1/maxParameter;
-    for(unsigned int i = 0; i <= degree; i++) {
-    T base = 0.0;
-    T mult = 1.0;
-    for(unsigned int j = 0; j+k <= degree; j++, mult *= u) {
-        if(j+k >= i) {
-        // base += pow(oneOverA, i) * this->comb(degree-i, j+k-i)
-        //       * pow(-oneOverA, j+k-i) * this->perm(j+k, k)
-        //       * mult;
+    // d!/(d-k)! / maxParameter^k
+    T scale = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        scale *= (degree - i) / maxParameter;
+    }
 
-        base += splx::internal::comb(degree-i, j+k-i)
-            * splx::internal::pow(oneOverA, j+k) * splx::internal::perm(j+k, k)
-            * mult * ((j+k-i)%2 == 0 ? 1 : -1);
+    // kth forward difference of control points starting from j
+    auto difference = [&cpts, k](unsigned int j) {
+        VectorDIM diff(cpts.rows());
+        diff.setZero();
+        T coeff = (k % 2 == 0 ? 1 : -1);
+        for(unsigned int i = 0; i <= k; i++) {
+            diff += coeff * cpts.col(j + i);
+            coeff = -coeff * (k - i) / (i + 1);
         }
+        return diff;
+    };
+
+    if(hodographDegree == 0) {
+        return scale * difference(0);
     }
-    base *= splx::internal::comb(degree, i);
-    result(i) = base;
+
+    const T t = u / maxParameter;
+    const T s = 1 - t;
+    T tPow = 1;
+    T binom = 1;
+    result = difference(0) * s;
+    for(unsigned int j = 1; j < hodographDegree; j++) {
+        tPow *= t;
+        binom = binom * (hodographDegree - j + 1) / j;
+        result = (result + tPow * binom * difference(j)) * s;
+    }
+    result += tPow * t * difference(hodographDegree);
+
+    return scale * result;
+}
+
+/*
+* evaluate 0th to kmax^th derivatives of the bezier curve whose control points
+* are the columns of cpts and that is defined for u \in [0, maxParameter].
+* k^th derivative is written to result.col(k), so result must have
+* kmax + 1 columns. work must have as many columns as cpts and is overwritten.
+*
+* de casteljau's algorithm is run once. k^th derivative is computed from the
+* k + 1 points of the de casteljau triangle at level d - k
+* f^k(u) = d!/(d-k)! / maxParameter^k * \sum_{i=0}^k (-1)^(k-i) C(k, i) b^{d-k}_i
+* so all derivatives share the same triangle. takes O(d^2 + kmax^2)
+* operations and does not allocate.
+*
+* does not check whether u is in [0, maxParameter].
+*/
+template<typename Derived, typename WorkDerived, typename ResultDerived>
+void evalDerivatives(const Eigen::MatrixBase<Derived>& cpts,
+                     typename Derived::Scalar maxParameter,
+                     typename Derived::Scalar u,
+                     unsigned int kmax,
+                     const Eigen::MatrixBase<WorkDerived>& work_,
+                     const Eigen::MatrixBase<ResultDerived>& result_) {
+    using T = typename Derived::Scalar;
+
+    // outputs are taken as const references so that temporary blocks can be
+    // passed, see eigen documentation on writing functions taking eigen types
+    auto& work = const_cast<Eigen::MatrixBase<WorkDerived>&>(work_);
+    auto& result = const_cast<Eigen::MatrixBase<ResultDerived>&>(result_);
+
+    result.setZero();
+
+    const Index numControlPoints = cpts.cols();
+    if(numControlPoints == 0) {
+        return;
+    }
+
+    if(maxParameter == 0) {
+        result.col(0) = cpts.col(0);
+        return;
+    }
+
+    const unsigned int degree = numControlPoints - 1;
+    const unsigned int K = std::min(kmax, degree);
+    const T t = u / maxParameter;
+    const T s = 1 - t;
+
+    work = cpts;
+    for(unsigned int level = 1; level + K <= degree; level++) {
+        for(unsigned int i = 0; i + level <= degree; i++) {
+            work.col(i) = s * work.col(i) + t * work.col(i+1);
+        }
+    }
+
+    T oneOverAPowk = 1;
+    for(unsigned int k = 0; k < K; k++) {
+        oneOverAPowk /= maxParameter;
+    }
+
+    for(unsigned int k = K + 1; k-- > 0; ) {
+        // columns 0 to k of work are the points at level d - k
+        T coeff = (k % 2 == 0 ? 1 : -1);
+        for(unsigned int i = 0; i <= k; i++) {
+            result.col(k) += coeff * work.col(i);
+            coeff = -coeff * (k - i) / (i + 1);
+        }
+        result.col(k) *= splx::internal::fallingFactorial<T>(degree, k) * oneOverAPowk;
+        oneOverAPowk *= maxParameter;
+
+        for(unsigned int i = 0; i < k; i++) {
+            work.col(i) = s * work.col(i) + t * work.col(i+1);
+        }
+    }
+}
+
+/*
+* write the bernstein basis polynomials of given degree at t \in [0, 1] to
+* the first degree + 1 entries of result, using the recurrence
+* b^r_i = (1 - t) b^{r-1}_i + t b^{r-1}_{i-1}. all terms are non negative so
+* there is no cancellation at high degrees, unlike the power basis. takes
+* O(d^2) operations and does not allocate.
+*/
+template<typename T, typename ResultDerived>
+void fillBernsteinBasis(unsigned int degree, T t,
+                        const Eigen::MatrixBase<ResultDerived>& result_) noexcept {
+    auto& result = const_cast<Eigen::MatrixBase<ResultDerived>&>(result_);
+    const T s = 1 - t;
+
+    result(0) = 1;
+    for(unsigned int r = 1; r <= degree; r++) {
+        result(r) = t * result(r-1);
+        for(unsigned int i = r - 1; i > 0; i--) {
+            result(i) = s * result(i) + t * result(i-1);
+        }
+        result(0) *= s;
+    }
+}
+
+/*
+* write the control points of the kth derivative of the bezier curve whose
+* control points are the columns of cpts and that is defined for
+* u \in [0, maxParameter] to the first cpts.cols() - k columns of result.
+* the kth derivative is a bezier curve of degree d - k over the same
+* parameter range. k must be less than the number of control points and
+* maxParameter must be positive. does not allocate.
+*/
+template<typename Derived, typename ResultDerived>
+void derivativeControlPoints(const Eigen::MatrixBase<Derived>& cpts,
+                             typename Derived::Scalar maxParameter,
+                             unsigned int k,
+                             const Eigen::MatrixBase<ResultDerived>& result_) noexcept {
+    using T = typename Derived::Scalar;
+    auto& result = const_cast<Eigen::MatrixBase<ResultDerived>&>(result_);
+
+    const unsigned int degree = cpts.cols() - 1;
+    result.leftCols(cpts.cols()) = cpts;
+    for(unsigned int r = 1; r <= k; r++) {
+        const T scale = (degree - r + 1) / maxParameter;
+        for(unsigned int i = 0; i + r <= degree; i++) {
+            result.col(i) = scale * (result.col(i+1) - result.col(i));
+        }
     }
-    return result;
 }
 
 /*
@@ -75,16 +306,8 @@ Matrix<T> bernsteinCoefficientMatrix(unsigned int degree, T maxParameter, unsign
         return bernsteinMtr;
     }
 
-    unsigned int dcombi = 1;
-    for(Index i = 0; 
-
-        i < degree+1; 
-
-        dcombi *= (degree-i), 
-        dcombi /= (i+1), 
-        i++) {
-
-        unsigned int dminicombjmini = 1;
+    for(Index i = 0; i < degree+1; i++) {
+        const T dcombi = splx::internal::binomial<T>(degree, i);
         T min1 = 1;
         T oneOverAPowj = splx::internal::pow(1/maxParameter, i);
 
@@ -92,13 +315,13 @@ Matrix<T> bernsteinCoefficientMatrix(unsigned int degree, T maxParameter, unsign
 
             j < degree+1; 
 
-            dminicombjmini *= (degree - j), 
-            dminicombjmini/= (j+1-i), 
             j++, 
             min1 *= -1, 
             oneOverAPowj *= (1/maxParameter)) {
 
-            bernsteinMtr(i, j) = dcombi * dminicombjmini * min1 * oneOverAPowj;
+            bernsteinMtr(i, j) = dcombi 
+                                 * splx::internal::binomial<T>(degree-i, j-i)
+                                 * min1 * oneOverAPowj;
 
         }
     }
@@ -106,20 +329,45 @@ Matrix<T> bernsteinCoefficientMatrix(unsigned int degree, T maxParameter, unsign
     Matrix<T> derivative(degree+1, degree+1);
     derivative.setZero();
 
-    unsigned int jpermk = splx::internal::fac(k);
-    for(unsigned int j = k;
-        
-        j < degree+1;
-        
-        jpermk *= (j+1),
-        jpermk /= (j+1-k),
-        j++) {
-        derivative(j, j-k) = jpermk;
+    for(unsigned int j = k; j < degree+1; j++) {
+        derivative(j, j-k) = splx::internal::fallingFactorial<T>(j, k);
     }
 
     return bernsteinMtr * derivative;
 }
 
+/*
+    Gram matrix of the k^th derivatives of the bernstein polynomials of given degree
+    over [0, 1], where entry (i, j) is the integral of the product of k^th derivatives
+    of i^th and j^th polynomials. The matrix for max parameter a is a^(1-2k) times
+    this matrix. Computed once per degree and k, and shared by all threads.
+*/
+template<typename T>
+const Matrix<T>& bernsteinDerivativeGramMatrix(unsigned int degree, unsigned int k) {
+    static std::map<std::pair<unsigned int, unsigned int>, Matrix<T>> cache;
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(std::make_pair(degree, k));
+    if(it == cache.end()) {
+        Matrix<T> bern = bernsteinCoefficientMatrix<T>(degree, 1, k);
+
+        Matrix<T> SQI(degree+1, degree+1);
+        for(Index i = 0; i < degree+1; i++) {
+            for(Index j = 0; j < degree+1; j++) {
+                SQI(i, j) = T(1) / (i+j+1);
+            }
+        }
+
+        it = cache.emplace(
+            std::make_pair(degree, k), bern * SQI * bern.transpose()
+        ).first;
+    }
+
+    // entries of a std::map are never moved, so the reference stays valid
+    return it->second;
+}
+
 } // namespace bezier
 } // namespace internal
 } // namespace splx
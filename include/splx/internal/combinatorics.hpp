@@ -3,30 +3,153 @@
 
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+
+/*
+* Largest degree for which binomial coefficients and falling factorials are
+* tabulated at compile time. Larger degrees are still supported but their
+* coefficients are computed with loops.
+*/
+#ifndef SPLX_MAX_DEGREE
+#define SPLX_MAX_DEGREE 32
+#endif
 
 namespace splx {
 namespace internal {
 
-unsigned int fac(unsigned int n) {
-    unsigned int res = 1;
+constexpr unsigned int MAX_DEGREE = SPLX_MAX_DEGREE;
+
+/*
+* Tables of C(n, k) and n!/(n-k)! for 0 <= k <= n <= MAX_DEGREE, generated at
+* compile time. Entries are stored as T so that they do not overflow for
+* large n. Entries with k > n are 0.
+*/
+template<typename T>
+struct CombinatoricsTable {
+    using Table = std::array<std::array<T, MAX_DEGREE + 1>, MAX_DEGREE + 1>;
+
+    static constexpr Table makeBinomial() {
+        Table table{};
+        for(unsigned int n = 0; n <= MAX_DEGREE; n++) {
+            table[n][0] = 1;
+            for(unsigned int k = 1; k <= n; k++) {
+                table[n][k] = table[n-1][k-1] + (k < n ? table[n-1][k] : T(0));
+            }
+        }
+        return table;
+    }
+
+    static constexpr Table makeFallingFactorial() {
+        Table table{};
+        for(unsigned int n = 0; n <= MAX_DEGREE; n++) {
+            table[n][0] = 1;
+            for(unsigned int k = 1; k <= n; k++) {
+                table[n][k] = table[n][k-1] * (n - k + 1);
+            }
+        }
+        return table;
+    }
+
+    static constexpr Table binomial = makeBinomial();
+    static constexpr Table fallingFactorial = makeFallingFactorial();
+};
+
+/*
+* C(n, k) as T. Looked up from the table if n <= MAX_DEGREE
+*/
+template<typename T>
+constexpr T binomial(unsigned int n, unsigned int k) {
+    if(k > n) {
+        return 0;
+    }
+
+    if(n <= MAX_DEGREE) {
+        return CombinatoricsTable<T>::binomial[n][k];
+    }
+
+    k = std::min(k, n-k);
+    T res = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        res = res * (n - i) / (i + 1);
+    }
+    return res;
+}
+
+/*
+* n!/(n-k)! as T. Looked up from the table if n <= MAX_DEGREE
+*/
+template<typename T>
+constexpr T fallingFactorial(unsigned int n, unsigned int k) {
+    if(k > n) {
+        return 0;
+    }
+
+    if(n <= MAX_DEGREE) {
+        return CombinatoricsTable<T>::fallingFactorial[n][k];
+    }
+
+    T res = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        res *= (n - i);
+    }
+    return res;
+}
+
+/*
+* n!, exact for n <= 20
+*/
+constexpr std::uint64_t fac(unsigned int n) {
+    std::uint64_t res = 1;
     for(unsigned int i = 2; i<=n; i++)
         res *= i;
     return res;
 }
 
-unsigned int comb(unsigned int n, unsigned int k) {
+/*
+* C(n, k), exact for n <= 62
+*/
+constexpr std::uint64_t comb(unsigned int n, unsigned int k) {
+    if(k > n) {
+        return 0;
+    }
+
     k = std::min(k, n-k);
-    unsigned int top = 1;
-    unsigned int bottom = 1;
-    for(unsigned int i=0; i<k; i++) {
-        bottom *= (i+1);
-        top *= (n-i);
+    std::uint64_t res = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        // res * (n-i) is divisible by i+1 since it equals C(n, i+1) * (i+1)
+        res = res * (n - i) / (i + 1);
     }
-    return top / bottom;
+    return res;
 }
 
-unsigned int perm(unsigned int n, unsigned int k) {
-    return fac(n) / fac(n-k);
+/*
+* n!/(n-k)!, exact as long as the result fits into 64 bits
+*/
+constexpr std::uint64_t perm(unsigned int n, unsigned int k) {
+    if(k > n) {
+        return 0;
+    }
+
+    std::uint64_t res = 1;
+    for(unsigned int i = 0; i < k; i++) {
+        res *= (n - i);
+    }
+    return res;
+}
+
+/*
+* returns C(n, 0), C(n, 1), ..., C(n, n), computed at compile time
+* when used in a constant expression
+*/
+template<typename T, unsigned int n>
+constexpr std::array<T, n + 1> binomialRow() {
+    std::array<T, n + 1> row{};
+    row[0] = 1;
+    for(unsigned int i = 1; i <= n; i++) {
+        row[i] = row[i-1] * (n - i + 1) / i;
+    }
+    return row;
 }
 
 template<typename T>
@@ -40,4 +163,4 @@ T pow(T base, unsigned int exp) {
 } // namespace internal
 } // namespace splx
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,135 @@
+#ifndef SPLX_INTERNAL_FENWICK_H
+#define SPLX_INTERNAL_FENWICK_H
+
+#include <cstddef>
+#include <vector>
+
+namespace splx {
+namespace internal {
+
+/*
+* Fenwick (binary indexed) tree over non-negative values, e.g. durations of
+* the pieces of a piecewise curve. Setting a value, appending a value,
+* prefix sums and finding the index of a prefix sum take O(log n).
+*
+* Prefix sums and searches add the same tree nodes in the same order, so
+* a search for prefixSum(i) returns i even with rounding errors.
+*
+* Setting a value recomputes the affected nodes from the values instead of
+* adding the difference to them, which takes O(log^2 n). The tree is then
+* always the one that appending the values builds, so rounding errors do
+* not accumulate when values are set many times.
+*/
+template<typename T>
+class FenwickTree {
+public:
+    std::size_t size() const noexcept {
+        return m_values.size();
+    }
+
+    bool empty() const noexcept {
+        return m_values.empty();
+    }
+
+    void clear() noexcept {
+        m_values.clear();
+        m_tree.resize(1);
+    }
+
+    // reserve space for n values
+    void reserve(std::size_t n) {
+        m_values.reserve(n);
+        m_tree.reserve(n + 1);
+    }
+
+    // value with index idx
+    T operator[](std::size_t idx) const noexcept {
+        return m_values[idx];
+    }
+
+    // append a value
+    void push_back(T value) {
+        m_values.push_back(value);
+        m_tree.push_back(this->node(m_values.size()));
+    }
+
+    // set the value with index idx
+    void set(std::size_t idx, T value) noexcept {
+        m_values[idx] = value;
+        for(std::size_t pos = idx + 1; pos < m_tree.size(); pos += lowbit(pos)) {
+            m_tree[pos] = this->node(pos);
+        }
+    }
+
+    // sum of values with indices 0 to idx
+    T prefixSum(std::size_t idx) const noexcept {
+        T sum = 0;
+        std::size_t pos = 0;
+        for(std::size_t step = highbit(m_values.size()); step != 0; step >>= 1) {
+            if(pos + step <= idx + 1) {
+                pos += step;
+                sum += m_tree[pos];
+            }
+        }
+        return sum;
+    }
+
+    // sum of all values
+    T sum() const noexcept {
+        return m_values.empty() ? T(0) : this->prefixSum(m_values.size() - 1);
+    }
+
+    /*
+    * smallest index idx such that prefixSum(idx) >= u. returns size() if
+    * there is no such index.
+    */
+    std::size_t lowerBound(T u) const noexcept {
+        T sum = 0;
+        std::size_t pos = 0;
+        for(std::size_t step = highbit(m_values.size()); step != 0; step >>= 1) {
+            if(pos + step < m_tree.size() && sum + m_tree[pos + step] < u) {
+                pos += step;
+                sum += m_tree[pos];
+            }
+        }
+        return pos;
+    }
+
+private:
+    /*
+    * m_values[i] is the i^th value. m_tree is 1 indexed, m_tree[pos] is the
+    * sum of values with indices pos - lowbit(pos) to pos - 1.
+    */
+    std::vector<T> m_values;
+    std::vector<T> m_tree = std::vector<T>(1, T(0));
+
+    /*
+    * sum of values covered by node pos, computed from the value pos - 1 and
+    * the nodes pos - 1, pos - 2, pos - 4, ... below pos, which must be up to
+    * date.
+    */
+    T node(std::size_t pos) const noexcept {
+        T sum = m_values[pos - 1];
+        for(std::size_t step = 1; step < lowbit(pos); step <<= 1) {
+            sum += m_tree[pos - step];
+        }
+        return sum;
+    }
+
+    static std::size_t lowbit(std::size_t pos) noexcept {
+        return pos & (~pos + 1);
+    }
+
+    static std::size_t highbit(std::size_t n) noexcept {
+        std::size_t bit = 1;
+        while(bit <= n / 2) {
+            bit <<= 1;
+        }
+        return n == 0 ? 0 : bit;
+    }
+};
+
+} // namespace internal
+} // namespace splx
+
+#endif
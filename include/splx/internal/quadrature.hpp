@@ -0,0 +1,40 @@
+#ifndef SPLX_INTERNAL_QUADRATURE_H
+#define SPLX_INTERNAL_QUADRATURE_H
+
+namespace splx {
+namespace internal {
+
+/*
+* integral of f over [a, b] with 5 point gauss-legendre quadrature. exact
+* for polynomials of degree up to 9.
+*/
+template<typename T, typename F>
+T gaussLegendre(const F& f, T a, T b) {
+    constexpr T nodes[5] = {
+        0.0,
+        -0.5384693101056830910363144,
+        0.5384693101056830910363144,
+        -0.9061798459386639927976269,
+        0.9061798459386639927976269
+    };
+    constexpr T weights[5] = {
+        0.5688888888888888888888889,
+        0.4786286704993664680412915,
+        0.4786286704993664680412915,
+        0.2369268850561890875142640,
+        0.2369268850561890875142640
+    };
+
+    const T halfLength = (b - a) / 2;
+    const T center = (a + b) / 2;
+    T sum = 0;
+    for(unsigned int i = 0; i < 5; i++) {
+        sum += weights[i] * f(center + halfLength * nodes[i]);
+    }
+    return sum * halfLength;
+}
+
+} // namespace internal
+} // namespace splx
+
+#endif
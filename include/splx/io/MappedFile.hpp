@@ -0,0 +1,76 @@
+#ifndef SPLX_IO_MAPPEDFILE_HPP
+#define SPLX_IO_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace splx {
+namespace io {
+
+/*
+* Read only memory mapping of a whole file. The file is unmapped when the
+* object is destroyed, so views over data() must not outlive it.
+*/
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path): m_data(nullptr), m_size(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::runtime_error(std::string("could not open ") + path);
+        }
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("could not stat ") + path);
+        }
+
+        m_size = st.st_size;
+        if(m_size != 0) {
+            void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error(std::string("could not map ") + path);
+            }
+            m_data = data;
+        }
+
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if(m_data != nullptr) {
+            ::munmap(m_data, m_size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& rhs) noexcept: m_data(rhs.m_data), m_size(rhs.m_size) {
+        rhs.m_data = nullptr;
+        rhs.m_size = 0;
+    }
+
+    const void* data() const {
+        return m_data;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+private:
+    void* m_data;
+    std::size_t m_size;
+};
+
+} // namespace io
+} // namespace splx
+
+#endif
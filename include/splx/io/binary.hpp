@@ -0,0 +1,179 @@
+#ifndef SPLX_IO_BINARY_HPP
+#define SPLX_IO_BINARY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <splx/curve/PiecewiseCurve.hpp>
+
+namespace splx {
+namespace io {
+
+/*
+* Binary layout of piecewise bezier curves. A file consists of
+*
+*   BinaryHeader
+*   piece table:    BinaryPiece[numPieces]
+*   durations:      T[numPieces], max parameter of each piece
+*   ends:           T[numPieces], parameter where each piece ends
+*   control points: T[DIM * numControlPoints], one control point after
+*                   another
+*
+* Each section starts at the byte offset given in the header, which is a
+* multiple of BINARY_ALIGNMENT, so a memory mapped file can be read in place
+* by PiecewiseCurveView. Values are stored in the byte order of the writer,
+* which is recorded by writing BINARY_BYTE_ORDER to the header.
+*
+* Version 2 added the byte order field to the header.
+*/
+
+constexpr char BINARY_MAGIC[4] = {'S', 'P', 'L', 'X'};
+constexpr std::uint32_t BINARY_VERSION = 2;
+constexpr std::uint64_t BINARY_BYTE_ORDER = 0x0102030405060708;
+constexpr std::uint64_t BINARY_ALIGNMENT = 64;
+
+struct BinaryHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t scalarSize;
+    std::uint32_t dimension;
+    std::uint64_t byteOrder; // BINARY_BYTE_ORDER in the byte order of the writer
+    std::uint64_t numPieces;
+    std::uint64_t numControlPoints;
+    std::uint64_t pieceTableOffset;
+    std::uint64_t durationsOffset;
+    std::uint64_t endsOffset;
+    std::uint64_t controlPointsOffset;
+    std::uint64_t size; // size of the whole file in bytes
+};
+
+/*
+* Control points of a piece are control points offset to
+* offset + numControlPoints - 1 of the control point section.
+*/
+struct BinaryPiece {
+    std::uint64_t offset;
+    std::uint64_t numControlPoints;
+};
+
+namespace internal {
+
+// a + b, throws if the sum does not fit in 64 bits
+inline std::uint64_t checkedAdd(std::uint64_t a, std::uint64_t b) {
+    if(a > std::numeric_limits<std::uint64_t>::max() - b) {
+        throw std::domain_error(
+            std::string("binary layout size overflows")
+        );
+    }
+    return a + b;
+}
+
+// a * b, throws if the product does not fit in 64 bits
+inline std::uint64_t checkedMul(std::uint64_t a, std::uint64_t b) {
+    if(b != 0 && a > std::numeric_limits<std::uint64_t>::max() / b) {
+        throw std::domain_error(
+            std::string("binary layout size overflows")
+        );
+    }
+    return a * b;
+}
+
+inline std::uint64_t alignUp(std::uint64_t offset) {
+    return checkedAdd(offset, BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT;
+}
+
+/*
+* header of a curve with given sizes, with all offsets filled. Throws if the
+* sizes come from a corrupted header and the layout size overflows.
+*/
+template<typename T, unsigned int DIM>
+BinaryHeader makeHeader(std::uint64_t numPieces, std::uint64_t numControlPoints) {
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.scalarSize = sizeof(T);
+    header.dimension = DIM;
+    header.byteOrder = BINARY_BYTE_ORDER;
+    header.numPieces = numPieces;
+    header.numControlPoints = numControlPoints;
+    header.pieceTableOffset = alignUp(sizeof(BinaryHeader));
+    header.durationsOffset = alignUp(checkedAdd(
+        header.pieceTableOffset, checkedMul(numPieces, sizeof(BinaryPiece))
+    ));
+    header.endsOffset = alignUp(checkedAdd(
+        header.durationsOffset, checkedMul(numPieces, sizeof(T))
+    ));
+    header.controlPointsOffset = alignUp(checkedAdd(
+        header.endsOffset, checkedMul(numPieces, sizeof(T))
+    ));
+    header.size = checkedAdd(
+        header.controlPointsOffset, checkedMul(numControlPoints, DIM * sizeof(T))
+    );
+    return header;
+}
+
+} // namespace internal
+
+/*
+* Serialize the curve to the binary layout.
+*/
+template<typename T, unsigned int DIM>
+std::vector<char> toBinary(const PiecewiseCurve<T, DIM>& curve) {
+    const std::uint64_t numPieces = curve.numPieces();
+    std::uint64_t numControlPoints = 0;
+    for(std::size_t i = 0; i < numPieces; i++) {
+        numControlPoints += curve.pieceControlPoints(i).cols();
+    }
+
+    const BinaryHeader header = internal::makeHeader<T, DIM>(numPieces, numControlPoints);
+    std::vector<char> buffer(header.size, 0);
+    std::memcpy(buffer.data(), &header, sizeof(BinaryHeader));
+
+    std::uint64_t offset = 0;
+    T end = 0;
+    for(std::size_t i = 0; i < numPieces; i++) {
+        const auto cpts = curve.pieceControlPoints(i);
+        const BinaryPiece piece{offset, static_cast<std::uint64_t>(cpts.cols())};
+        const T duration = curve.pieceMaxParameter(i);
+        end += duration;
+
+        std::memcpy(buffer.data() + header.pieceTableOffset + i * sizeof(BinaryPiece),
+                    &piece, sizeof(BinaryPiece));
+        std::memcpy(buffer.data() + header.durationsOffset + i * sizeof(T),
+                    &duration, sizeof(T));
+        std::memcpy(buffer.data() + header.endsOffset + i * sizeof(T),
+                    &end, sizeof(T));
+        if(cpts.cols() != 0) {
+            std::memcpy(buffer.data() + header.controlPointsOffset + offset * DIM * sizeof(T),
+                        cpts.data(), cpts.size() * sizeof(T));
+        }
+
+        offset += cpts.cols();
+    }
+
+    return buffer;
+}
+
+/*
+* Write the curve to the file at path in the binary layout.
+*/
+template<typename T, unsigned int DIM>
+void writeBinary(const PiecewiseCurve<T, DIM>& curve, const std::string& path) {
+    const std::vector<char> buffer = toBinary(curve);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), buffer.size());
+    if(!file) {
+        throw std::runtime_error(
+            std::string("could not write piecewise curve to ") + path
+        );
+    }
+}
+
+} // namespace io
+} // namespace splx
+
+#endif
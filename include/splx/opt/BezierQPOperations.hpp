@@ -5,6 +5,7 @@
 #include <splx/types.hpp>
 #include <absl/strings/str_cat.h>
 #include <splx/curve/Bezier.hpp>
+#include <cmath>
 
 
 namespace splx {
@@ -23,6 +24,7 @@ public:
     using _ParametricCurve = ParametricCurve<T, DIM>;
     using _Bezier = Bezier<T, DIM>;
     using Constraint = splx::Constraint<T>;
+    using SparseRow = splx::SparseRow<T>;
 
     BezierQPOperations(Index ncpts, T a) 
         : _Base(ncpts * DIM, a), m_ncpts(ncpts) {
@@ -62,33 +64,20 @@ public:
         c.setZero();
 
 
-        if(k <= this->degree()) {
-            Matrix bern = splx::internal::bezier::bernsteinCoefficientMatrix(
-                                    this->degree(), 
-                                    _Base::maxParameter(), 
+        if(k <= this->degree() && _Base::maxParameter() > 0) {
+            const Matrix& gram
+                = splx::internal::bezier::bernsteinDerivativeGramMatrix<T>(
+                                    this->degree(),
                                     k
             );
-
-            Matrix SQI(this->numControlPoints(), this->numControlPoints());
-            SQI.setZero();
-
-            for(Index i = 0; i < this->numControlPoints(); i++) {
-                for(Index j = 0; j < this->numControlPoints(); j++) {
-                    SQI(i, j) = splx::internal::pow(
-                                    _Base::maxParameter(), 
-                                    i + j + 1) / (i+j+1);
-                }
-            }
-            
-            Matrix cost = 2 * lambda * bern * SQI * bern.transpose();
-
-            
+            const T scale = 2 * lambda
+                * std::pow(_Base::maxParameter(), T(1) - T(2) * k);
 
             for(unsigned int i = 0; i < DIM; i++) {
                 Q.block(i*this->numControlPoints(), 
                             i*this->numControlPoints(), 
                             this->numControlPoints(), 
-                            this->numControlPoints()) = cost;
+                            this->numControlPoints()) = scale * gram;
             }
 
         }
@@ -149,12 +138,14 @@ public:
         );
 
         std::vector<Constraint> constraints;
+        constraints.reserve(DIM);
         for(unsigned int i = 0; i < DIM; i++) {
-            Row coeff(_Base::numDecisionVariables());
-            coeff.setZero();
-            coeff.block(0, i*this->numControlPoints(), 
-                        1, this->numControlPoints()) = basis;
-            constraints.emplace_back(coeff, target(i), target(i),
+            SparseRow coeff(_Base::numDecisionVariables());
+            coeff.reserve(this->numControlPoints());
+            for(Index j = 0; j < this->numControlPoints(); j++) {
+                coeff.insertBack(i*this->numControlPoints() + j) = basis(j);
+            }
+            constraints.emplace_back(std::move(coeff), target(i), target(i),
                     soft_convertible, soft_convertible_weight);
         }
         return constraints;
@@ -166,13 +157,16 @@ public:
                     T soft_convertible_weight = T(1)) const override {
 
         std::vector<Constraint> constraints;
+        constraints.reserve(this->numControlPoints());
         for(Index i = 0; i < this->numControlPoints(); i++) {
-            Row coeff(_Base::numDecisionVariables());
-            coeff.setZero();
+            SparseRow coeff(_Base::numDecisionVariables());
+            coeff.reserve(DIM);
             for(Index j = 0; j < DIM; j++) {
-                coeff(j * this->numControlPoints() + i) = hp.normal()(j);
+                if(hp.normal()(j) != 0) {
+                    coeff.insertBack(j * this->numControlPoints() + i) = hp.normal()(j);
+                }
             }
-            constraints.emplace_back(coeff, 
+            constraints.emplace_back(std::move(coeff), 
                                      std::numeric_limits<T>::lowest(), 
                                      -hp.offset(),
                                      soft_convertible, soft_convertible_weight
@@ -270,6 +264,7 @@ public:
         }
 
         typename _Bezier::ControlPoints cpts;
+        cpts.reserve(this->numControlPoints());
         for(Index i = 0; i < this->numControlPoints(); i++) {
             VectorDIM cpt;
             for(Index j = 0; j < DIM; j++) {
@@ -278,7 +273,9 @@ public:
             cpts.push_back(cpt);
         }
 
-        auto bezptr = std::make_shared<_Bezier>(_Base::maxParameter(), cpts);
+        auto bezptr = std::make_shared<_Bezier>(
+                            _Base::maxParameter(), std::move(cpts)
+        );
 
         return std::static_pointer_cast<_ParametricCurve>(bezptr);
     }
@@ -9,9 +9,32 @@
 #include <splx/opt/BezierQPOperations.hpp>
 #include <absl/strings/str_cat.h>
 #include <Eigen/StdVector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace splx {
 
+/*
+* Builds a QPWrappers::Problem for a piecewise curve whose decision
+* variables are the parameters of its pieces.
+*
+* QPWrappers::Problem::add_Q takes a dense matrix, so the problem always
+* holds a dense N x N Q for N decision variables, however Q is assembled
+* here. Sparse assembly can not reduce the memory of the problem until the
+* wrapper accepts a sparse Q. It only applies to the Q returned by
+* integratedSquaredDerivativeCost and deferredCost, e.g. for callers that
+* pass it to a sparse solver themselves.
+*
+* Likewise, QPWrappers::Problem::add_constraint takes a dense row.
+* Constraint rows are kept sparse until they are added to the problem,
+* e.g. in deferredConstraints, and are converted to dense rows of N
+* entries there.
+*/
 template<typename T, unsigned int DIM>
 class PiecewiseCurveQPGenerator {
 public:
@@ -24,6 +47,9 @@ public:
     using AlignedBox = splx::AlignedBox<T, DIM>;
     using Index = splx::Index;
     using Matrix = splx::Matrix<T>;
+    using SparseMatrix = splx::SparseMatrix<T>;
+    using Triplet = splx::Triplet<T>;
+    using SparseRow = splx::SparseRow<T>;
     using _QPOperations = QPOperations<T, DIM>;
     using _PiecewiseCurve = PiecewiseCurve<T, DIM>;
     using StdVectorVectorDIM
@@ -37,7 +63,10 @@ public:
         
         if(m_cumulativeMaxParameters.empty()) {
             m_cumulativeMaxParameters.push_back(opt_ptr->maxParameter());
+            m_uniformMaxParameters = true;
         } else {
+            m_uniformMaxParameters = m_uniformMaxParameters
+                && opt_ptr->maxParameter() == m_operations[0]->maxParameter();
             m_cumulativeMaxParameters.push_back(
                 m_cumulativeMaxParameters.back() + opt_ptr->maxParameter()
             );
@@ -52,13 +81,13 @@ public:
             );
         }
 
-        m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+        this->piecesChanged();
     }
 
     void setPiece(std::size_t idx, std::shared_ptr<_QPOperations> opt_ptr) {
         m_operations[idx] = opt_ptr;
         this->fixCumulativeStructures(idx);
-        m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+        this->piecesChanged();
     }
 
     void removePiece(std::size_t idx) {
@@ -70,14 +99,15 @@ public:
                 m_cumulativeMaxParameters.begin() + idx
         );
         this->fixCumulativeStructures(idx);
-        m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+        this->piecesChanged();
     }
 
     void removeAllPieces() {
         m_operations.clear();
         m_cumulativeMaxParameters.clear();
         m_cumulativeDecisionVars.clear();
-        m_problem = QPWrappers::Problem<T>(0);
+        m_uniformMaxParameters = true;
+        this->piecesChanged();
     }
 
     void addBezier(Index ncpts, T a) {
@@ -134,7 +164,7 @@ public:
         }
 
         this->fixCumulativeStructures(0);
-        m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+        this->piecesChanged();
     }
 
     Index numDecisionVariables() const {
@@ -143,7 +173,51 @@ public:
         return m_cumulativeDecisionVars.back();
     }
     
+    /*
+    * Q and c of the integrated squared k^th derivative cost over all pieces.
+    * Q is block diagonal with one block per piece and is returned sparse,
+    * built from the non-zeros of the blocks. The cost added to the problem
+    * by addIntegratedSquaredDerivativeCost is dense, see the class
+    * comment.
+    */
+    std::pair<SparseMatrix, Vector>
+    integratedSquaredDerivativeCost(unsigned int k, T lambda) const {
+        std::vector<Triplet> triplets;
+        Vector c(this->numDecisionVariables());
+        c.setZero();
+
+        for(std::size_t i = 0; i < this->numPieces(); i++) {
+            Index dvar_start_idx = (i == 0 ? 0 : m_cumulativeDecisionVars[i-1]);
+            Index dvar_count = m_operations[i]->numDecisionVariables();
+
+            auto [Qs, cs]
+                = m_operations[i]->integratedSquaredDerivativeCost(k, lambda);
+
+            this->appendTriplets(triplets, Qs, dvar_start_idx);
+            c.block(dvar_start_idx, 0, dvar_count, 1) = cs;
+        }
+
+        SparseMatrix Q(this->numDecisionVariables(), this->numDecisionVariables());
+        Q.setFromTriplets(triplets.begin(), triplets.end());
+        return std::make_pair(std::move(Q), std::move(c));
+    }
+
+    /*
+    * Adds the integrated squared k^th derivative cost to the problem.
+    * QPWrappers::Problem::add_Q takes a dense matrix, so Q is assembled
+    * densely block by block as a N x N matrix. Deferred assembly adds a
+    * single dense Q for many costs, but it is N x N as well.
+    */
     void addIntegratedSquaredDerivativeCost(unsigned int k, T lambda) {
+        if(m_deferAssembly) {
+            for(std::size_t i = 0; i < this->numPieces(); i++) {
+                auto [Qs, cs]
+                    = m_operations[i]->integratedSquaredDerivativeCost(k, lambda);
+                this->accumulatePieceCost(i, Qs, cs);
+            }
+            return;
+        }
+
         Matrix Q(this->numDecisionVariables(), this->numDecisionVariables());
         Vector c(this->numDecisionVariables());
         Q.setZero();
@@ -155,29 +229,35 @@ public:
 
             auto [Qs, cs]
                 = m_operations[i]->integratedSquaredDerivativeCost(k, lambda);
-            
+
             Q.block(dvar_start_idx, dvar_start_idx, dvar_count, dvar_count) = Qs;
             c.block(dvar_start_idx, 0, dvar_count, 1) = cs;
         }
 
         m_problem.add_Q(Q);
         m_problem.add_c(c);
+        m_problemAssembled = true;
     }
 
     void addEvalCost(T u, unsigned int k, const VectorDIM& target, T lambda) {
+        auto [idx, param, first_dvar_index, dvar_count] = pieceInfo(u);
+        auto [Qs, cs] = m_operations[idx]->evalCost(param, k, target, lambda);
+        if(m_deferAssembly) {
+            this->accumulatePieceCost(idx, Qs, cs);
+            return;
+        }
+
         Matrix Q(this->numDecisionVariables(), this->numDecisionVariables());
         Vector c(this->numDecisionVariables());
         Q.setZero();
         c.setZero();
-
-        auto [idx, param, first_dvar_index, dvar_count] = pieceInfo(u);
-        auto [Qs, cs] = m_operations[idx]->evalCost(param, k, target, lambda);
-        Q.block(first_dvar_index, first_dvar_index, 
+        Q.block(first_dvar_index, first_dvar_index,
                 dvar_count, dvar_count) = Qs;
         c.block(first_dvar_index, 0, dvar_count, 1) = cs;
 
         m_problem.add_Q(Q);
         m_problem.add_c(c);
+        m_problemAssembled = true;
     }
 
     void addEvalConstraint(T u, unsigned int k, const VectorDIM& target,
@@ -230,9 +310,26 @@ public:
 
             assert(lbx.rows() == dvar_count);
 
+            if(m_deferAssembly) {
+                if(m_deferredLowerLimits.size() == 0) {
+                    m_deferredLowerLimits.setConstant(
+                        this->numDecisionVariables(),
+                        std::numeric_limits<T>::lowest()
+                    );
+                    m_deferredUpperLimits.setConstant(
+                        this->numDecisionVariables(),
+                        std::numeric_limits<T>::max()
+                    );
+                }
+                m_deferredLowerLimits.block(first_dvar_index, 0, dvar_count, 1) = lbx;
+                m_deferredUpperLimits.block(first_dvar_index, 0, dvar_count, 1) = ubx;
+                continue;
+            }
+
             for(Index j = 0; j < dvar_count; j++) {
                 m_problem.set_var_limits(first_dvar_index + j, lbx(j), ubx(j));
             }
+            m_problemAssembled = true;
         }
     }
 
@@ -241,6 +338,10 @@ public:
     void addContinuityConstraint(std::size_t idx, unsigned int k,
                                  bool soft_convertible = false,
                                  T soft_convertible_weight = T(1)) {
+        if(m_eliminateContinuity && k <= m_eliminatedContinuityOrder) {
+            return;
+        }
+
         Index first_piece_numdvars = m_operations[idx]->numDecisionVariables();
         Index second_piece_numdvars = 
                 m_operations[idx+1]->numDecisionVariables();
@@ -256,14 +357,21 @@ public:
                             d, 0, k
             );
 
-            Row coeff(this->numDecisionVariables());
-            coeff.setZero();
-            coeff.block(0, first_piece_dvars_start, 1, first_piece_numdvars) 
-                                = coeff1;
-            coeff.block(0, second_piece_dvars_start, 1, second_piece_numdvars)
-                                = -coeff2;
+            SparseRow coeff(this->numDecisionVariables());
+            coeff.reserve(first_piece_numdvars + second_piece_numdvars);
+            for(Index j = 0; j < first_piece_numdvars; j++) {
+                if(coeff1(j) != 0) {
+                    coeff.insertBack(first_piece_dvars_start + j) = coeff1(j);
+                }
+            }
+            for(Index j = 0; j < second_piece_numdvars; j++) {
+                if(coeff2(j) != 0) {
+                    coeff.insertBack(second_piece_dvars_start + j) = -coeff2(j);
+                }
+            }
 
-            m_problem.add_constraint(coeff, 0, 0, soft_convertible, soft_convertible_weight);
+            this->emitConstraint(std::move(coeff), 0, 0,
+                                 soft_convertible, soft_convertible_weight);
         }
     }
 
@@ -298,41 +406,321 @@ public:
 
         return res;
     }
-    _PiecewiseCurve extractCurve(const Vector& soln) {
-        if(soln.rows() != this->numDecisionVariables()) {
+    /*
+    * Converts a solution of the problem to a piecewise curve. When
+    * continuity is eliminated, soln is a solution of the reduced problem.
+    */
+    _PiecewiseCurve extractCurve(const Vector& soln) const {
+        if(m_eliminateContinuity) {
+            const SparseMatrix& map = this->continuityEliminationMap();
+            if(soln.rows() != map.cols()) {
+                throw std::domain_error(
+                    absl::StrCat(
+                        "number of reduced decision variables does not match. given: ",
+                        soln.rows(),
+                        ", required: ",
+                        map.cols()
+                    )
+                );
+            }
+            return this->extractFullCurve(map * soln);
+        }
+
+        return this->extractFullCurve(soln);
+    }
+
+    /*
+    * Enforces continuity of derivatives 0 to k at all joints by eliminating
+    * decision variables instead of adding equality constraints. The first
+    * k + 1 control points of each piece after the first are written as
+    * linear combinations of the control points before them, so the problem
+    * has fewer decision variables and no continuity rows. Pieces must be
+    * beziers with positive max parameters and at least k + 1 control
+    * points.
+    *
+    * Elimination is applied by finalize, so it turns deferred assembly
+    * on. The first finalize creates the problem over the reduced decision
+    * variables, and every finalize adds the deferred contributions to it
+    * until pieces change. addContinuityConstraint is a no-op for
+    * derivatives up to k. Fails if the problem already has contributions
+    * over other decision variables, which would be lost.
+    */
+    void eliminateContinuity(unsigned int k) {
+        if(m_eliminateContinuity && m_eliminatedContinuityOrder == k) {
+            m_deferAssembly = true;
+            return;
+        }
+
+        this->problemVariablesChangeCheck();
+        m_eliminateContinuity = true;
+        m_eliminatedContinuityOrder = k;
+        m_deferAssembly = true;
+        m_eliminationMapValid = false;
+        this->restoreFullProblem();
+    }
+
+    /*
+    * Goes back to continuity constraints. Fails if the reduced problem
+    * already has contributions, which would be lost.
+    */
+    void disableContinuityElimination() {
+        if(!m_eliminateContinuity) {
+            return;
+        }
+
+        this->problemVariablesChangeCheck();
+        m_eliminateContinuity = false;
+        this->restoreFullProblem();
+    }
+
+    bool eliminatesContinuity() const {
+        return m_eliminateContinuity;
+    }
+
+    /*
+    * Matrix M such that the decision variables are M times the reduced
+    * decision variables when continuity is eliminated. Row j is the
+    * combination of reduced variables that gives decision variable j.
+    * M is computed once and kept until pieces or the eliminated order
+    * change.
+    */
+    const SparseMatrix& continuityEliminationMap() const {
+        if(!m_eliminationMapValid) {
+            m_eliminationMap = this->computeContinuityEliminationMap();
+            m_eliminationMapValid = true;
+        }
+        return m_eliminationMap;
+    }
+
+    /*
+    * number of decision variables of the problem, which are the reduced
+    * decision variables when continuity is eliminated
+    */
+    Index numReducedVariables() const {
+        if(!m_eliminateContinuity) {
+            return this->numDecisionVariables();
+        }
+        return this->continuityEliminationMap().cols();
+    }
+
+    /*
+    * When set, costs and constraints are not added to the problem right
+    * away. Costs are accumulated in one block per piece and constraints are
+    * kept as sparse rows until finalize() adds all of them to the problem
+    * at once. Contributions are dropped when pieces change or the problem
+    * is reset. Turning it off disables continuity elimination.
+    */
+    void deferAssembly(bool defer) {
+        if(!defer) {
+            this->disableContinuityElimination();
+        }
+        m_deferAssembly = defer;
+    }
+
+    bool deferAssembly() const {
+        return m_deferAssembly;
+    }
+
+    /*
+    * Q and c accumulated in deferred mode, with Q assembled from the piece
+    * blocks in a single pass.
+    */
+    std::pair<SparseMatrix, Vector> deferredCost() const {
+        std::size_t nnz = 0;
+        for(const auto& block: m_deferredQ) {
+            nnz += block.size();
+        }
+
+        std::vector<Triplet> triplets;
+        triplets.reserve(nnz);
+        for(std::size_t i = 0; i < m_deferredQ.size(); i++) {
+            this->appendTriplets(triplets, m_deferredQ[i],
+                                 i == 0 ? 0 : m_cumulativeDecisionVars[i-1]);
+        }
+
+        SparseMatrix Q(this->numDecisionVariables(), this->numDecisionVariables());
+        Q.setFromTriplets(triplets.begin(), triplets.end());
+
+        Vector c = m_deferredC;
+        if(c.size() == 0) {
+            c.setZero(this->numDecisionVariables());
+        }
+        return std::make_pair(std::move(Q), std::move(c));
+    }
+
+    /*
+    * constraints accumulated in deferred mode. coefficients are over the
+    * decision variables of the whole curve.
+    */
+    const std::vector<Constraint>& deferredConstraints() const {
+        return m_deferredConstraints;
+    }
+
+    /*
+    * Adds the costs and constraints accumulated in deferred mode to the
+    * problem and clears them. Q and c are added once. When continuity is
+    * eliminated, they are added to the problem over the reduced decision
+    * variables, see eliminateContinuity.
+    */
+    void finalize() {
+        if(m_eliminateContinuity) {
+            this->finalizeReduced();
+            return;
+        }
+
+        if(m_deferredC.size() != 0) {
+            // add_Q takes a dense matrix, see the class comment
+            auto [Q, c] = this->deferredCost();
+            m_problem.add_Q(Matrix(Q));
+            m_problem.add_c(c);
+        }
+
+        for(const auto& constraint: m_deferredConstraints) {
+            m_problem.add_constraint(Row(constraint.coeff),
+                                     constraint.lb,
+                                     constraint.ub,
+                                     constraint.soft_convertible,
+                                     constraint.soft_weight
+            );
+        }
+
+        this->applyLimits(m_problem, m_deferredLowerLimits, m_deferredUpperLimits);
+
+        this->clearDeferred();
+        m_problemAssembled = true;
+    }
+
+    /*
+    * Returns true if the problem accumulated in deferred mode splits into
+    * one independent problem per dimension, i.e. all pieces are beziers,
+    * and no cost or constraint couples decision variables of different
+    * dimensions. Integrated, eval and bounding box costs and constraints
+    * never couple dimensions. Hyperplane constraints couple them unless
+    * their normals are axis aligned. Fails if assembly is not deferred or
+    * the problem already has contributions that are not deferred, e.g.
+    * after finalize.
+    */
+    bool isAxisSeparable() const {
+        this->deferredProblemCheck();
+        for(std::size_t i = 0; i < this->numPieces(); i++) {
+            if(dynamic_cast<const _BezierQPOperations*>(m_operations[i].get()) == nullptr) {
+                return false;
+            }
+
+            const Matrix& block = m_deferredQ[i];
+            const Index ncpts = m_operations[i]->numDecisionVariables() / DIM;
+            for(Index r = 0; r < block.rows(); r++) {
+                for(Index c = 0; c < block.cols(); c++) {
+                    if(r / ncpts != c / ncpts && block(r, c) != 0) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        for(const auto& constraint: m_deferredConstraints) {
+            if(this->constraintDimension(constraint) == DIM) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+    * Splits the problem accumulated in deferred mode into DIM independent
+    * problems, where problem d has the control points of dimension d as its
+    * decision variables in piece order. The problems are assembled in
+    * parallel and can be solved in parallel. Their solutions are merged
+    * with extractCurve. Fails if the problem is not axis separable or
+    * continuity is eliminated, and in the cases isAxisSeparable fails.
+    */
+    std::vector<_Problem> axisProblems() const {
+        if(m_eliminateContinuity || !this->isAxisSeparable()) {
+            throw std::logic_error(
+                absl::StrCat(
+                    "deferred problem couples dimensions and can not be ",
+                    "split into per dimension problems"
+                )
+            );
+        }
+
+        const Index axis_numdvars = this->numDecisionVariables() / DIM;
+        std::vector<_Problem> problems;
+        problems.reserve(DIM);
+        for(unsigned int d = 0; d < DIM; d++) {
+            problems.emplace_back(axis_numdvars);
+        }
+
+        std::vector<std::thread> threads;
+        for(unsigned int d = 0; d < DIM; d++) {
+            threads.emplace_back([this, d, &problems]() {
+                this->assembleAxisProblem(d, problems[d]);
+            });
+        }
+        for(auto& thread: threads) {
+            thread.join();
+        }
+
+        return problems;
+    }
+
+    /*
+    * Merges solutions of axisProblems, one per dimension, and converts them
+    * to a piecewise curve.
+    */
+    _PiecewiseCurve extractCurve(const std::vector<Vector>& axis_solns) const {
+        const Index axis_numdvars = this->numDecisionVariables() / DIM;
+        if(axis_solns.size() != DIM) {
             throw std::domain_error(
                 absl::StrCat(
-                    "number of decision variables does not match. given: ",
-                    soln.rows(),
+                    "number of axis solutions does not match. given: ",
+                    axis_solns.size(),
                     ", required: ",
-                    this->numDecisionVariables()
+                    DIM
                 )
             );
         }
 
-        _PiecewiseCurve piecewise;
-        for(std::size_t i = 0; i < this->numPieces(); i++) {
-            Index piece_numdvars = m_operations[i]->numDecisionVariables();
-            Index piece_dvars_start = 
-                    (i==0 ? 0 : m_cumulativeDecisionVars[i-1]);
-            
-            Vector dvars = soln.block(piece_dvars_start, 0, piece_numdvars, 1);
-            piecewise.addPiece(m_operations[i]->extractCurve(dvars));
+        Vector soln(this->numDecisionVariables());
+        for(unsigned int d = 0; d < DIM; d++) {
+            if(axis_solns[d].rows() != axis_numdvars) {
+                throw std::domain_error(
+                    absl::StrCat(
+                        "number of decision variables of axis solution ",
+                        d,
+                        " does not match. given: ",
+                        axis_solns[d].rows(),
+                        ", required: ",
+                        axis_numdvars
+                    )
+                );
+            }
+
+            for(std::size_t i = 0; i < this->numPieces(); i++) {
+                Index piece_dvars_start
+                    = (i == 0 ? 0 : m_cumulativeDecisionVars[i-1]);
+                Index ncpts = m_operations[i]->numDecisionVariables() / DIM;
+                soln.block(piece_dvars_start + d * ncpts, 0, ncpts, 1)
+                    = axis_solns[d].block(piece_dvars_start / DIM, 0, ncpts, 1);
+            }
         }
 
-        return piecewise;
+        return this->extractFullCurve(soln);
     }
 
-
     void resetProblem() {
         m_problem.reset();
+        m_problemAssembled = false;
+        this->clearDeferred();
     }
 
     void resetGenerator() {
         m_operations.clear();
         m_cumulativeMaxParameters.clear();
         m_cumulativeDecisionVars.clear();
-        this->resetProblem();
+        m_uniformMaxParameters = true;
+        this->piecesChanged();
     }
 
     const QPWrappers::Problem<T>& getProblem() const {
@@ -345,10 +733,486 @@ private:
     std::vector<Index> m_cumulativeDecisionVars;
     QPWrappers::Problem<T> m_problem;
 
+    /*
+    * true if all pieces have the same max parameter, in which case the
+    * piece of a parameter is found by division in pieceInfo
+    */
+    bool m_uniformMaxParameters = true;
+
+    // see deferAssembly
+    bool m_deferAssembly = false;
+
+    /*
+    * true if costs, constraints or limits are added to m_problem since it
+    * was created or reset, directly or by finalize. Deferred contributions
+    * then do not describe the whole problem.
+    */
+    bool m_problemAssembled = false;
+
+    // see eliminateContinuity
+    bool m_eliminateContinuity = false;
+    unsigned int m_eliminatedContinuityOrder = 0;
+
+    // true if m_problem is over the reduced decision variables
+    bool m_problemReduced = false;
+
+    /*
+    * cache of continuityEliminationMap, valid until pieces or the
+    * eliminated order change
+    */
+    mutable SparseMatrix m_eliminationMap;
+    mutable bool m_eliminationMapValid = false;
+
+    /*
+    * costs accumulated in deferred mode. m_deferredQ[i] is the block of
+    * piece i, empty if no cost is added to it. m_deferredC is empty if no
+    * cost is added.
+    */
+    std::vector<Matrix> m_deferredQ;
+    Vector m_deferredC;
+
+    // constraints accumulated in deferred mode
+    std::vector<Constraint> m_deferredConstraints;
+
+    /*
+    * variable limits set in deferred mode, empty if no limit is set.
+    * unlimited variables have limits lowest() and max().
+    */
+    Vector m_deferredLowerLimits;
+    Vector m_deferredUpperLimits;
+
+    // converts a solution over all decision variables to a piecewise curve
+    _PiecewiseCurve extractFullCurve(const Vector& soln) const {
+        if(soln.rows() != this->numDecisionVariables()) {
+            throw std::domain_error(
+                absl::StrCat(
+                    "number of decision variables does not match. given: ",
+                    soln.rows(),
+                    ", required: ",
+                    this->numDecisionVariables()
+                )
+            );
+        }
+
+        /*
+        * bezier pieces are written into the curve directly from soln, whose
+        * segment for a piece stores control points dimension by dimension.
+        * other pieces go through QPOperations::extractCurve.
+        */
+        _PiecewiseCurve piecewise;
+        piecewise.reserve(this->numPieces(), this->numDecisionVariables() / DIM);
+        for(std::size_t i = 0; i < this->numPieces(); i++) {
+            Index piece_numdvars = m_operations[i]->numDecisionVariables();
+            Index piece_dvars_start = 
+                    (i==0 ? 0 : m_cumulativeDecisionVars[i-1]);
+
+            const auto bezptr = dynamic_cast<const _BezierQPOperations*>(
+                                    m_operations[i].get()
+            );
+            if(bezptr != nullptr) {
+                Eigen::Map<const Matrix> cpts(
+                    soln.data() + piece_dvars_start,
+                    bezptr->numControlPoints(),
+                    DIM
+                );
+                piecewise.emplacePiece(
+                    bezptr->maxParameter(), cpts.transpose()
+                );
+            } else {
+                Vector dvars = soln.block(piece_dvars_start, 0, piece_numdvars, 1);
+                piecewise.addPiece(m_operations[i]->extractCurve(dvars));
+            }
+        }
+
+        return piecewise;
+    }
+
+    // see continuityEliminationMap
+    SparseMatrix computeContinuityEliminationMap() const {
+        const unsigned int K = m_eliminatedContinuityOrder;
+        const Index N = this->numDecisionVariables();
+
+        // orders[g] is the derivative whose continuity eliminates g, -1 if free
+        std::vector<int> orders(N, -1);
+        for(std::size_t p = 1; p < this->numPieces(); p++) {
+            if(dynamic_cast<const _BezierQPOperations*>(m_operations[p-1].get()) == nullptr
+                || dynamic_cast<const _BezierQPOperations*>(m_operations[p].get()) == nullptr) {
+                throw std::logic_error(
+                    absl::StrCat("continuity can only be eliminated between beziers")
+                );
+            }
+
+            Index ncpts = m_operations[p]->numDecisionVariables() / DIM;
+            if(ncpts < static_cast<Index>(K) + 1 || m_operations[p]->maxParameter() == 0) {
+                throw std::domain_error(
+                    absl::StrCat(
+                        "continuity up to derivative ",
+                        K,
+                        " can not be eliminated at the start of piece ",
+                        p,
+                        ". number of control points: ",
+                        ncpts,
+                        ", max parameter: ",
+                        m_operations[p]->maxParameter()
+                    )
+                );
+            }
+
+            for(unsigned int d = 0; d < DIM; d++) {
+                for(unsigned int j = 0; j <= K; j++) {
+                    orders[m_cumulativeDecisionVars[p-1] + d * ncpts + j] = j;
+                }
+            }
+        }
+
+        Index M = 0;
+        std::vector<Index> reduced_index(N, -1);
+        for(Index g = 0; g < N; g++) {
+            if(orders[g] == -1) {
+                reduced_index[g] = M++;
+            }
+        }
+
+        /*
+        * combinations are found in increasing variable order. continuity of
+        * derivative j at the start of a piece involves its first j + 1
+        * control points and control points of the previous piece, which
+        * are all found before.
+        */
+        std::vector<SparseRow> combinations(N, SparseRow(M));
+        for(Index g = 0; g < N; g++) {
+            if(orders[g] == -1) {
+                combinations[g].insert(reduced_index[g]) = 1;
+                continue;
+            }
+
+            std::size_t p = std::upper_bound(m_cumulativeDecisionVars.begin(),
+                                             m_cumulativeDecisionVars.end(),
+                                             g)
+                          - m_cumulativeDecisionVars.begin();
+            Index start = m_cumulativeDecisionVars[p-1];
+            Index previous_start = (p == 1 ? 0 : m_cumulativeDecisionVars[p-2]);
+            Index ncpts = m_operations[p]->numDecisionVariables() / DIM;
+            unsigned int d = (g - start) / ncpts;
+            unsigned int j = orders[g];
+
+            Row previous_row = m_operations[p-1]->evalBasisRow(
+                                    d, m_operations[p-1]->maxParameter(), j
+            );
+            Row row = m_operations[p]->evalBasisRow(d, 0, j);
+
+            SparseRow combination(M);
+            for(Index m = 0; m < previous_row.cols(); m++) {
+                if(previous_row(m) != 0) {
+                    combination += previous_row(m) * combinations[previous_start + m];
+                }
+            }
+            for(Index m = 0; m < row.cols(); m++) {
+                if(row(m) != 0 && start + m != g) {
+                    assert(start + m < g);
+                    combination -= row(m) * combinations[start + m];
+                }
+            }
+            combinations[g] = combination / row(g - start);
+        }
+
+        std::vector<Triplet> triplets;
+        for(Index g = 0; g < N; g++) {
+            for(typename SparseRow::InnerIterator it(combinations[g]); it; ++it) {
+                triplets.emplace_back(g, it.index(), it.value());
+            }
+        }
+
+        SparseMatrix map(N, M);
+        map.setFromTriplets(triplets.begin(), triplets.end());
+        return map;
+    }
+
+    /*
+    * adds the deferred problem in terms of the reduced decision variables
+    * to the problem, which is created over them on the first call. limits
+    * of eliminated variables become constraints.
+    */
+    void finalizeReduced() {
+        const SparseMatrix& map = this->continuityEliminationMap();
+        if(!m_problemReduced) {
+            assert(!m_problemAssembled);
+            m_problem = QPWrappers::Problem<T>(map.cols());
+            m_problemReduced = true;
+        }
+
+        if(m_deferredC.size() != 0) {
+            auto [Q, c] = this->deferredCost();
+            SparseMatrix reduced_Q = map.transpose() * Q * map;
+            Vector reduced_c = map.transpose() * c;
+            m_problem.add_Q(Matrix(reduced_Q));
+            m_problem.add_c(reduced_c);
+        }
+
+        for(const auto& constraint: m_deferredConstraints) {
+            SparseRow coeff = constraint.coeff * map;
+            m_problem.add_constraint(Row(coeff),
+                                     constraint.lb,
+                                     constraint.ub,
+                                     constraint.soft_convertible,
+                                     constraint.soft_weight
+            );
+        }
+
+        if(m_deferredLowerLimits.size() != 0) {
+            const Eigen::SparseMatrix<T, Eigen::RowMajor> rows = map;
+            Vector lbx(map.cols());
+            Vector ubx(map.cols());
+            lbx.setConstant(std::numeric_limits<T>::lowest());
+            ubx.setConstant(std::numeric_limits<T>::max());
+            for(Index g = 0; g < rows.rows(); g++) {
+                const T lb = m_deferredLowerLimits(g);
+                const T ub = m_deferredUpperLimits(g);
+                if(lb == std::numeric_limits<T>::lowest()
+                    && ub == std::numeric_limits<T>::max()) {
+                    continue;
+                }
+
+                typename Eigen::SparseMatrix<T, Eigen::RowMajor>::InnerIterator it(rows, g);
+                if(rows.row(g).nonZeros() == 1 && it.value() == 1) {
+                    lbx(it.index()) = std::max(lbx(it.index()), lb);
+                    ubx(it.index()) = std::min(ubx(it.index()), ub);
+                } else {
+                    SparseRow coeff = rows.row(g);
+                    m_problem.add_constraint(Row(coeff), lb, ub);
+                }
+            }
+            this->applyLimits(m_problem, lbx, ubx);
+        }
+
+        this->clearDeferred();
+        m_problemAssembled = true;
+    }
+
+    /*
+    * checks if the deferred contributions describe the whole problem, i.e.
+    * assembly is deferred and nothing is added to the problem directly or
+    * by finalize
+    */
+    void deferredProblemCheck() const {
+        if(!m_deferAssembly || m_problemAssembled) {
+            throw std::logic_error(
+                absl::StrCat(
+                    "axis problems require deferred assembly of a problem ",
+                    "that is neither finalized nor added to directly"
+                )
+            );
+        }
+    }
+
+    // recreates the problem over the decision variables of the pieces
+    void piecesChanged() {
+        m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+        m_problemAssembled = false;
+        m_problemReduced = false;
+        m_eliminationMapValid = false;
+        this->clearDeferred();
+    }
+
+    /*
+    * checks if the decision variables of the problem can change, i.e. the
+    * problem has no contributions that would be lost
+    */
+    void problemVariablesChangeCheck() const {
+        if(m_problemAssembled) {
+            throw std::logic_error(
+                absl::StrCat(
+                    "decision variables of the problem can not change after ",
+                    "contributions are added to it. reset the problem first"
+                )
+            );
+        }
+    }
+
+    // recreates the problem over all decision variables if it is reduced
+    void restoreFullProblem() {
+        if(m_problemReduced) {
+            m_problem = QPWrappers::Problem<T>(this->numDecisionVariables());
+            m_problemReduced = false;
+        }
+    }
+
+    // drops contributions accumulated in deferred mode
+    void clearDeferred() {
+        m_deferredQ.assign(this->numPieces(), Matrix());
+        m_deferredC.resize(0);
+        m_deferredConstraints.clear();
+        m_deferredLowerLimits.resize(0);
+        m_deferredUpperLimits.resize(0);
+    }
+
+    // sets limits of the variables whose limits are not lowest() and max()
+    static void applyLimits(_Problem& problem, const Vector& lbx, const Vector& ubx) {
+        for(Index j = 0; j < lbx.rows(); j++) {
+            if(lbx(j) != std::numeric_limits<T>::lowest()
+                || ubx(j) != std::numeric_limits<T>::max()) {
+                problem.set_var_limits(j, lbx(j), ubx(j));
+            }
+        }
+    }
+
+    /*
+    * dimension and index among the variables of that dimension of the
+    * decision variable with index dvar. pieces must be beziers.
+    */
+    std::pair<unsigned int, Index> axisIndex(Index dvar) const {
+        std::size_t idx = std::upper_bound(m_cumulativeDecisionVars.begin(),
+                                           m_cumulativeDecisionVars.end(),
+                                           dvar)
+                        - m_cumulativeDecisionVars.begin();
+        Index piece_dvars_start = (idx == 0 ? 0 : m_cumulativeDecisionVars[idx-1]);
+        Index ncpts = m_operations[idx]->numDecisionVariables() / DIM;
+        Index local = dvar - piece_dvars_start;
+        return std::make_pair(local / ncpts, piece_dvars_start / DIM + local % ncpts);
+    }
+
+    /*
+    * dimension of the variables of the constraint, 0 if it has no
+    * variables and DIM if it has variables of multiple dimensions.
+    */
+    unsigned int constraintDimension(const Constraint& constraint) const {
+        unsigned int dimension = DIM;
+        for(typename SparseRow::InnerIterator it(constraint.coeff); it; ++it) {
+            if(it.value() == 0) {
+                continue;
+            }
+            const unsigned int d = this->axisIndex(it.index()).first;
+            if(dimension != DIM && dimension != d) {
+                return DIM;
+            }
+            dimension = d;
+        }
+        return dimension == DIM ? 0 : dimension;
+    }
+
+    // adds the deferred costs and constraints of dimension d to problem
+    void assembleAxisProblem(unsigned int d, _Problem& problem) const {
+        const Index axis_numdvars = this->numDecisionVariables() / DIM;
+
+        std::vector<Triplet> triplets;
+        Vector c(axis_numdvars);
+        c.setZero();
+        Vector lbx(axis_numdvars);
+        Vector ubx(axis_numdvars);
+        lbx.setConstant(std::numeric_limits<T>::lowest());
+        ubx.setConstant(std::numeric_limits<T>::max());
+        for(std::size_t i = 0; i < this->numPieces(); i++) {
+            Index piece_dvars_start = (i == 0 ? 0 : m_cumulativeDecisionVars[i-1]);
+            Index ncpts = m_operations[i]->numDecisionVariables() / DIM;
+            Index axis_start = piece_dvars_start / DIM;
+            Index dim_start = piece_dvars_start + d * ncpts;
+
+            if(m_deferredQ[i].size() != 0) {
+                this->appendTriplets(
+                    triplets,
+                    m_deferredQ[i].block(d * ncpts, d * ncpts, ncpts, ncpts),
+                    axis_start
+                );
+            }
+            if(m_deferredC.size() != 0) {
+                c.block(axis_start, 0, ncpts, 1)
+                    = m_deferredC.block(dim_start, 0, ncpts, 1);
+            }
+            if(m_deferredLowerLimits.size() != 0) {
+                lbx.block(axis_start, 0, ncpts, 1)
+                    = m_deferredLowerLimits.block(dim_start, 0, ncpts, 1);
+                ubx.block(axis_start, 0, ncpts, 1)
+                    = m_deferredUpperLimits.block(dim_start, 0, ncpts, 1);
+            }
+        }
+
+        if(m_deferredC.size() != 0) {
+            SparseMatrix Q(axis_numdvars, axis_numdvars);
+            Q.setFromTriplets(triplets.begin(), triplets.end());
+            problem.add_Q(Matrix(Q));
+            problem.add_c(c);
+        }
+
+        for(const auto& constraint: m_deferredConstraints) {
+            if(this->constraintDimension(constraint) != d) {
+                continue;
+            }
+
+            SparseRow coeff(axis_numdvars);
+            coeff.reserve(constraint.coeff.nonZeros());
+            for(typename SparseRow::InnerIterator it(constraint.coeff); it; ++it) {
+                if(it.value() != 0) {
+                    coeff.insertBack(this->axisIndex(it.index()).second) = it.value();
+                }
+            }
+            problem.add_constraint(Row(coeff),
+                                   constraint.lb,
+                                   constraint.ub,
+                                   constraint.soft_convertible,
+                                   constraint.soft_weight
+            );
+        }
+
+        this->applyLimits(problem, lbx, ubx);
+    }
+
+    // adds the cost Qs, cs of piece idx to the deferred costs
+    void accumulatePieceCost(std::size_t idx, const Matrix& Qs, const Vector& cs) {
+        Index first_dvar_index = (idx == 0 ? 0 : m_cumulativeDecisionVars[idx-1]);
+        Index dvar_count = m_operations[idx]->numDecisionVariables();
+
+        Matrix& block = m_deferredQ[idx];
+        if(block.size() == 0) {
+            block.setZero(dvar_count, dvar_count);
+        }
+        block += Qs;
+
+        if(m_deferredC.size() == 0) {
+            m_deferredC.setZero(this->numDecisionVariables());
+        }
+        m_deferredC.block(first_dvar_index, 0, dvar_count, 1) += cs;
+    }
+
+    /*
+    * adds the constraint to the problem, or keeps it until finalize in
+    * deferred mode
+    */
+    void emitConstraint(SparseRow&& coeff, T lb, T ub,
+                        bool soft_convertible, T soft_weight) {
+        if(m_deferAssembly) {
+            m_deferredConstraints.emplace_back(std::move(coeff), lb, ub,
+                                               soft_convertible, soft_weight);
+        } else {
+            m_problem.add_constraint(Row(coeff), lb, ub, soft_convertible, soft_weight);
+            m_problemAssembled = true;
+        }
+    }
+
+    /*
+    * appends the non-zero entries of the block Qs of a piece whose decision
+    * variables start at index start
+    */
+    static void appendTriplets(std::vector<Triplet>& triplets,
+                               const Eigen::Ref<const Matrix>& Qs, Index start) {
+        for(Index j = 0; j < Qs.cols(); j++) {
+            for(Index i = 0; i < Qs.rows(); i++) {
+                if(Qs(i, j) != 0) {
+                    triplets.emplace_back(start + i, start + j, Qs(i, j));
+                }
+            }
+        }
+    }
+
     /*
     * fix cumulative structures starting from the given index
     */
     void fixCumulativeStructures(std::size_t idx) {
+        m_uniformMaxParameters = true;
+        for(std::size_t i = 1; i < this->numPieces(); i++) {
+            m_uniformMaxParameters = m_uniformMaxParameters
+                && m_operations[i]->maxParameter() == m_operations[0]->maxParameter();
+        }
+
         for(std::size_t i = idx; i < this->numPieces(); i++) {
             if(i == 0) {
                 m_cumulativeMaxParameters[i] = m_operations[i]->maxParameter();
@@ -371,10 +1235,7 @@ private:
     * variable count for the piece
     */
     std::tuple<std::size_t, T, Index, Index> pieceInfo(T param) const {
-        std::size_t idx = std::lower_bound(
-                    m_cumulativeMaxParameters.begin(),
-                    m_cumulativeMaxParameters.end(),
-                    param) - m_cumulativeMaxParameters.begin();
+        std::size_t idx = this->pieceIndex(param);
 
         Index first_dvar_index = 0;
         Index dvar_count = m_operations[idx]->numDecisionVariables();
@@ -391,21 +1252,58 @@ private:
         };
     }
 
+    /*
+    * index of the piece that contains param, i.e. the first piece whose
+    * cumulative max parameter is not less than param. O(1) if max
+    * parameters are uniform, O(log n) otherwise.
+    */
+    std::size_t pieceIndex(T param) const {
+        const std::size_t numPieces = m_cumulativeMaxParameters.size();
+        if(!m_uniformMaxParameters || numPieces == 0
+            || m_operations[0]->maxParameter() <= 0) {
+            return std::lower_bound(
+                    m_cumulativeMaxParameters.begin(),
+                    m_cumulativeMaxParameters.end(),
+                    param) - m_cumulativeMaxParameters.begin();
+        }
+
+        // estimate is corrected against the cumulative max parameters so
+        // that the result is the same as the one of the binary search
+        const T estimate = std::ceil(param / m_operations[0]->maxParameter()) - 1;
+        std::size_t idx = estimate <= 0 ? 0 : std::min(
+            static_cast<std::size_t>(estimate), numPieces
+        );
+        while(idx < numPieces && m_cumulativeMaxParameters[idx] < param) {
+            idx++;
+        }
+        while(idx > 0 && m_cumulativeMaxParameters[idx-1] >= param) {
+            idx--;
+        }
+        return idx;
+    }
+
+    /*
+    * adds constraints of a piece whose decision variables start at index
+    * first_dvar_index. coefficients are shifted to the decision variables
+    * of the whole curve without densifying them.
+    */
     void addConstraints(const std::vector<Constraint>& cons,
                         Index first_dvar_index, Index dvar_count) {
 
-        Row coeff(this->numDecisionVariables());
-
         for(const auto& constraint: cons) {
-            coeff.setZero();
-            coeff.block(0, first_dvar_index, 1, dvar_count) 
-                        = constraint.coeff;
-            m_problem.add_constraint(coeff, 
-                                     constraint.lb,
-                                     constraint.ub,
-                                     constraint.soft_convertible,
-                                     constraint.soft_weight
-            );   
+            assert(constraint.coeff.size() == dvar_count);
+
+            SparseRow coeff(this->numDecisionVariables());
+            coeff.reserve(constraint.coeff.nonZeros());
+            for(typename SparseRow::InnerIterator it(constraint.coeff); it; ++it) {
+                coeff.insertBack(first_dvar_index + it.index()) = it.value();
+            }
+            this->emitConstraint(std::move(coeff),
+                                 constraint.lb,
+                                 constraint.ub,
+                                 constraint.soft_convertible,
+                                 constraint.soft_weight
+            );
         }
     }
 
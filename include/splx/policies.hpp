@@ -0,0 +1,58 @@
+#ifndef SPLX_POLICIES_HPP
+#define SPLX_POLICIES_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace splx {
+
+/*
+* Parameter policies of noexcept evaluation functions. Each policy maps a
+* parameter u to [0, maxParameter] without throwing or allocating.
+*/
+
+/*
+* Parameters outside of [0, maxParameter] are clamped to the closest end.
+*/
+struct ClampPolicy {
+    template<typename T>
+    static T apply(T u, T maxParameter) noexcept {
+        return std::min(std::max(u, T(0)), maxParameter);
+    }
+};
+
+/*
+* Parameters are wrapped around to [0, maxParameter) as if the curve is
+* periodic with period maxParameter.
+*/
+struct WrapPolicy {
+    template<typename T>
+    static T apply(T u, T maxParameter) noexcept {
+        if(maxParameter <= 0) {
+            return 0;
+        }
+
+        T wrapped = std::fmod(u, maxParameter);
+        if(wrapped < 0) {
+            wrapped += maxParameter;
+        }
+        return std::min(wrapped, maxParameter);
+    }
+};
+
+/*
+* Parameters are assumed to be in [0, maxParameter]. Checked with assert in
+* debug builds only.
+*/
+struct AssertPolicy {
+    template<typename T>
+    static T apply(T u, T maxParameter) noexcept {
+        assert(u >= 0 && u <= maxParameter);
+        return u;
+    }
+};
+
+} // namespace splx
+
+#endif
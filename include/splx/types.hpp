@@ -2,6 +2,8 @@
 #define SPLX_INTERNAL_TYPES_HPP
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <utility>
 
 namespace splx {
 
@@ -22,24 +24,49 @@ using Hyperplane = Eigen::Hyperplane<T, DIM>;
 
 using Index = Eigen::Index;
 
+template<typename T>
+using SparseMatrix = Eigen::SparseMatrix<T>;
+
+template<typename T>
+using Triplet = Eigen::Triplet<T>;
+
 template<typename T, unsigned int DIM>
 using AlignedBox = Eigen::AlignedBox<T, DIM>;
 
+template<typename T>
+using SparseRow = Eigen::SparseVector<T, Eigen::RowMajor>;
+
+/*
+* Linear constraint lb <= coeff * x <= ub. coeff is stored sparse since a
+* constraint usually involves the decision variables of a single piece.
+* coeff was a dense Row before, use denseCoeff where a dense row is needed.
+*/
 template<typename T>
 struct Constraint {
     using _Row = Row<T>;
+    using _SparseRow = SparseRow<T>;
 
     Constraint(const _Row& c, T l, T u, bool sc = false, T sw = T(1)):
-        coeff(c), lb(l), ub(u), soft_convertible(sc), soft_weight(sw) {
+        coeff(c.sparseView()), lb(l), ub(u), soft_convertible(sc), soft_weight(sw) {
 
     }
 
-    Constraint(const _Row&& c, T l, T u, bool sc = false, T sw = T(1)):
+    Constraint(_SparseRow&& c, T l, T u, bool sc = false, T sw = T(1)):
         coeff(std::move(c)), lb(l), ub(u), soft_convertible(sc), soft_weight(sw) {
 
     }
 
-    _Row coeff;
+    /*
+    * coeff as a dense row of coeff.size() entries, for code written against
+    * the dense coeff of earlier versions. That is the number of decision
+    * variables of a piece for constraints of QPOperations, and of the whole
+    * curve for constraints of PiecewiseCurveQPGenerator.
+    */
+    _Row denseCoeff() const {
+        return _Row(coeff);
+    }
+
+    _SparseRow coeff;
     T lb;
     T ub;
     bool soft_convertible;
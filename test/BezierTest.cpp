@@ -4,6 +4,7 @@
 #include <splx/curve/Bezier.hpp>
 #include <splx/internal/bezier.hpp>
 #include <stdexcept>
+#include <cmath>
 #include <splx/opt/BezierQPOperations.hpp>
 
 
@@ -136,6 +137,45 @@ TEST_CASE("initialization of Bezier curves", "[bezier]") {
         REQUIRE((bez.eval(2.76, 6) - bez.eval(3.4, 6)).norm() < double_eq_epsilon);
         REQUIRE((bez.eval(2.22, 7) - zero_vecdim).norm() < double_eq_epsilon);
 
+        SECTION("evalMany") {
+            Bez::Vector us(6);
+            us << 0, 0.1, 3.5, 0.111, 2.76, 1.2;
+            for(unsigned int k = 0; k < 8; k++) {
+                Bez::MatrixDIMX res = bez.evalMany(us, k);
+                REQUIRE(res.cols() == us.size());
+                for(Eigen::Index i = 0; i < us.size(); i++) {
+                    REQUIRE((res.col(i) - bez.eval(us(i), k)).norm() < double_eq_epsilon);
+                }
+            }
+
+            Eigen::Matrix<double, 2, 3, Eigen::RowMajor> strided;
+            strided << 0.2, 1.7, 3.1,
+                       0.0, 0.0, 0.0;
+            Bez::MatrixDIMX res(3, 3);
+            bez.evalMany(strided.col(0).transpose().head(1), 1, res.leftCols(1));
+            bez.evalMany(Eigen::Map<const Bez::Vector, 0, Eigen::InnerStride<>>(
+                            strided.data(), 3, Eigen::InnerStride<>(1)), 2, res);
+            for(Eigen::Index i = 0; i < 3; i++) {
+                REQUIRE((res.col(i) - bez.eval(strided(0, i), 2)).norm() < double_eq_epsilon);
+            }
+
+            us(1) = 3.50000001;
+            REQUIRE_THROWS_AS(bez.evalMany(us, 0), std::domain_error);
+            REQUIRE_THROWS_AS(bez.evalMany(us.head(2), 0, res), std::domain_error);
+        }
+
+        SECTION("evalDerivatives") {
+            for(double u : {0.0, 0.1, 1.2, 2.76, 3.5}) {
+                Bez::MatrixDIMX res = bez.evalDerivatives(u, 8);
+                REQUIRE(res.cols() == 9);
+                for(unsigned int k = 0; k <= 8; k++) {
+                    REQUIRE((res.col(k) - bez.eval(u, k)).norm()
+                                < double_eq_epsilon * std::max(1.0, res.col(k).norm()));
+                }
+            }
+
+            REQUIRE_THROWS_AS(bez.evalDerivatives(3.50000001, 2), std::domain_error);
+        }
     }
 }
 
@@ -164,3 +204,257 @@ TEST_CASE("splx::internal::bezier::bernsteinCoefficientMatrix test") {
 
     REQUIRE((bern.transpose()-mtr).squaredNorm() < double_eq_epsilon);
 }
+
+
+TEST_CASE("splx::internal::bezier::evalHorner matches basis row evaluation") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+
+    double double_eq_epsilon = 1e-9;
+
+    for(unsigned int degree = 0; degree < 12; degree++) {
+        Bez bez(1.7);
+        for(unsigned int i = 0; i <= degree; i++) {
+            bez.appendControlPoint(VectorDIM::Random());
+        }
+
+        for(unsigned int k = 0; k <= degree + 1; k++) {
+            for(double u = 0; u <= 1.7; u += 0.1) {
+                auto basis = splx::internal::bezier::getBasisRow(
+                                    bez.degree(), bez.maxParameter(), u, k);
+                VectorDIM expected = bez.controlPointMatrix() * basis.transpose();
+                VectorDIM result = splx::internal::bezier::evalHorner(
+                                    bez.controlPointMatrix(), bez.maxParameter(), u, k);
+                REQUIRE((result - expected).norm() 
+                            < double_eq_epsilon * std::max(1.0, expected.norm()));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("cached power basis coefficients are invalidated on modification", "[bezier]") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+
+    double double_eq_epsilon = 1e-12;
+
+    Bez bez(2.0, {{0, 0, 0}, {1, 2, 0}, {2, -1, 1}, {3, 0, 2}});
+
+    auto reference = [&bez](double u, unsigned int k) -> VectorDIM {
+        return splx::internal::bezier::evalHorner(
+                    bez.controlPointMatrix(), bez.maxParameter(), u, k);
+    };
+
+    auto check = [&]() {
+        bez.cachePowerBasis();
+        for(unsigned int k = 0; k < 5; k++) {
+            for(double u = 0; u <= bez.maxParameter(); u += 0.25) {
+                REQUIRE((bez.eval(u, k) - reference(u, k)).norm() < double_eq_epsilon);
+            }
+        }
+    };
+
+    check();
+
+    bez[1] = VectorDIM(-1, 4, 2);
+    check();
+
+    bez.appendControlPoint(VectorDIM(5, 5, 5));
+    check();
+
+    bez.removeControlPoint(0);
+    check();
+
+    bez.maxParameter(0.7);
+    check();
+
+    Bez copy(bez);
+    copy.cachePowerBasis();
+    copy[0] = VectorDIM(10, 10, 10);
+    check();
+    REQUIRE((copy.eval(0, 0) - VectorDIM(10, 10, 10)).norm() < double_eq_epsilon);
+}
+
+
+TEST_CASE("fixed degree bezier curves", "[bezier]") {
+    using Bez = splx::Bezier<double, 3>;
+    using FixedBez = splx::Bezier<double, 3, 6>;
+    using VectorDIM = Bez::VectorDIM;
+    using Hyperplane = Bez::Hyperplane;
+
+    double double_eq_epsilon = 1e-12;
+
+    Bez bez(3.5, {{1, 2, 3}, {3, 2, 1}, {2, 2.3, 3.4}, {3, 2.2, 3.1},
+                  {2.2314, 2.231, 2.22}, {-2.11, -.231, 1.2}, {-5, -5, -5}});
+    FixedBez fixed(bez);
+
+    REQUIRE(FixedBez::numControlPoints() == 7);
+    REQUIRE(FixedBez::degree() == 6);
+    REQUIRE(fixed.maxParameter() == 3.5);
+    REQUIRE(fixed[6] == VectorDIM(-5, -5, -5));
+
+    for(unsigned int k = 0; k < 9; k++) {
+        for(double u = 0; u <= 3.5; u += 0.05) {
+            REQUIRE((fixed.eval(u, k) - bez.eval(u, k)).norm()
+                        < double_eq_epsilon * std::max(1.0, bez.eval(u, k).norm()));
+        }
+    }
+
+    REQUIRE_THROWS_AS(fixed.eval(-1, 0), std::domain_error);
+    REQUIRE_THROWS_AS(fixed.eval(3.50000001, 0), std::domain_error);
+    REQUIRE_THROWS_AS(FixedBez(Bez(1, {{0, 0, 0}})), std::domain_error);
+    REQUIRE_THROWS_AS(fixed.maxParameter(-1), std::domain_error);
+
+    Hyperplane hp(VectorDIM(-1, -1, 2), -1);
+    REQUIRE(fixed.onNegativeSide(hp) == bez.onNegativeSide(hp));
+    REQUIRE(fixed.onNonPositiveSide(hp) == bez.onNonPositiveSide(hp));
+
+    Eigen::Matrix<double, 3, 5> derivatives = fixed.evalDerivatives<4>(1.1);
+    for(unsigned int k = 0; k <= 4; k++) {
+        REQUIRE((derivatives.col(k) - bez.eval(1.1, k)).norm()
+                    < double_eq_epsilon * std::max(1.0, bez.eval(1.1, k).norm()));
+    }
+
+    fixed[0] = VectorDIM(0, 0, 0);
+    Bez dyn = fixed.dynamic();
+    REQUIRE(dyn.numControlPoints() == 7);
+    REQUIRE(dyn[0] == VectorDIM(0, 0, 0));
+    REQUIRE((dyn.eval(1.3, 2) - fixed.eval(1.3, 2)).norm() < double_eq_epsilon);
+}
+
+
+TEST_CASE("splx::internal combinatorics", "[combinatorics]") {
+    static_assert(splx::internal::binomial<double>(7, 3) == 35);
+    static_assert(splx::internal::fallingFactorial<double>(7, 3) == 210);
+    static_assert(splx::internal::comb(62, 31) == 465428353255261088ULL);
+
+    REQUIRE(splx::internal::fac(20) == 2432902008176640000ULL);
+    REQUIRE(splx::internal::perm(13, 13) == 6227020800ULL);
+    REQUIRE(splx::internal::comb(5, 7) == 0);
+    REQUIRE(splx::internal::perm(5, 7) == 0);
+
+    for(unsigned int n = 0; n <= splx::internal::MAX_DEGREE + 5; n++) {
+        for(unsigned int k = 0; k <= n; k++) {
+            double expected = std::round(
+                std::exp(std::lgamma(n+1) - std::lgamma(k+1) - std::lgamma(n-k+1)));
+            REQUIRE(std::abs(splx::internal::binomial<double>(n, k) - expected)
+                        <= 1e-12 * expected);
+            REQUIRE(splx::internal::fallingFactorial<double>(n, k)
+                        == Approx(splx::internal::binomial<double>(n, k)
+                                    * std::tgamma(k+1)).epsilon(1e-12));
+        }
+    }
+}
+
+
+TEST_CASE("high degree basis rows", "[bezier]") {
+    using Bez = splx::Bezier<double, 2>;
+    using VectorDIM = Bez::VectorDIM;
+
+    for(unsigned int degree : {13u, 16u, 20u}) {
+        Bez bez(1.0);
+        for(unsigned int i = 0; i <= degree; i++) {
+            bez.appendControlPoint(VectorDIM(std::cos(i), std::sin(i)));
+        }
+
+        for(unsigned int k = 0; k <= 3; k++) {
+            for(double u = 0; u <= 1.0; u += 0.125) {
+                VectorDIM expected = splx::internal::bezier::evalHorner(
+                                        bez.controlPointMatrix(), 1.0, u, k);
+                auto basis = splx::internal::bezier::getBasisRow(degree, 1.0, u, k);
+                VectorDIM fromBasis = bez.controlPointMatrix() * basis.transpose();
+                REQUIRE((fromBasis - expected).norm() < 1e-6 * std::max(1.0, expected.norm()));
+                REQUIRE((bez.eval(u, k) - expected).norm() < 1e-6 * std::max(1.0, expected.norm()));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("memoized derivative curves", "[bezier]") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+    using Hyperplane = Bez::Hyperplane;
+
+    double double_eq_epsilon = 1e-12;
+
+    Bez bez(3.5, {{1, 2, 3}, {3, 2, 1}, {2, 2.3, 3.4}, {3, 2.2, 3.1},
+                  {2.2314, 2.231, 2.22}, {-2.11, -.231, 1.2}, {-5, -5, -5}});
+
+    REQUIRE(&bez.derivative(0) == &bez);
+
+    for(unsigned int k = 0; k <= 8; k++) {
+        const Bez& der = bez.derivative(k);
+        REQUIRE(der.maxParameter() == bez.maxParameter());
+        REQUIRE(der.degree() == (k <= 6 ? 6 - k : 0));
+        for(double u = 0; u <= 3.5; u += 0.25) {
+            REQUIRE((der.eval(u, 0) - bez.eval(u, k)).norm()
+                        < double_eq_epsilon * std::max(1.0, bez.eval(u, k).norm()));
+            REQUIRE((der.eval(u, 1) - bez.eval(u, k + 1)).norm()
+                        < double_eq_epsilon * std::max(1.0, bez.eval(u, k + 1).norm()));
+        }
+    }
+
+    REQUIRE(&bez.derivative(2) == &bez.derivative(1).derivative(1));
+
+    // velocity is bounded by the hull of the hodograph control points
+    Hyperplane hp(VectorDIM(1, 0, 0), -100);
+    REQUIRE(bez.derivative(1).onNegativeSide(hp));
+
+    bez[6] = VectorDIM(500, -5, -5);
+    REQUIRE(!bez.derivative(1).onNegativeSide(hp));
+    REQUIRE((bez.derivative(1).eval(3.5, 0) - bez.eval(3.5, 1)).norm()
+                < double_eq_epsilon * bez.eval(3.5, 1).norm());
+
+    bez.maxParameter(0);
+    REQUIRE(bez.derivative(1).eval(0, 0) == VectorDIM::Zero());
+}
+
+TEST_CASE("cached bounding boxes", "[bezier]") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+
+    Bez bez(2, {{1, 2, 3}, {3, -2, 1}, {2, 2.3, 3.4}});
+    REQUIRE(bez.boundingBox().min() == VectorDIM(1, -2, 1));
+    REQUIRE(bez.boundingBox().max() == VectorDIM(3, 2.3, 3.4));
+    for(double u = 0; u <= 2; u += 0.1) {
+        REQUIRE(bez.boundingBox().contains(bez.eval(u, 0)));
+    }
+
+    bez[1] = VectorDIM(5, 0, 0);
+    REQUIRE(bez.boundingBox().min() == VectorDIM(1, 0, 0));
+    REQUIRE(bez.boundingBox().max() == VectorDIM(5, 2.3, 3.4));
+
+    bez.appendControlPoint(VectorDIM(-1, 9, 0));
+    REQUIRE(bez.boundingBox().min() == VectorDIM(-1, 0, 0));
+    REQUIRE(bez.boundingBox().max() == VectorDIM(5, 9, 3.4));
+
+    REQUIRE(Bez().boundingBox().min() == VectorDIM::Zero());
+    REQUIRE(Bez().boundingBox().max() == VectorDIM::Zero());
+
+    splx::Bezier<double, 3, 3> fixedBez(bez);
+    REQUIRE(fixedBez.boundingBox().min() == bez.boundingBox().min());
+    REQUIRE(fixedBez.boundingBox().max() == bez.boundingBox().max());
+}
+
+TEST_CASE("high degree evaluation is stable", "[bezier]") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+
+    for(unsigned int degree : {7u, 10u, 15u, 20u}) {
+        Bez bez(1.5);
+        for(unsigned int i = 0; i <= degree; i++) {
+            bez.appendControlPoint(VectorDIM(std::sin(i), std::cos(2.0 * i), 0.1 * i));
+        }
+        bez.cachePowerBasis();
+
+        for(unsigned int k = 0; k <= 3; k++) {
+            for(double u = 0; u <= 1.5; u += 0.05) {
+                VectorDIM reference = splx::internal::bezier::evalHorner(
+                    bez.controlPointMatrix(), bez.maxParameter(), u, k);
+                REQUIRE((bez.eval(u, k) - reference).norm() < 1e-10 * (1 + reference.norm()));
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <splx/curve/Bezier.hpp>
+#include <splx/curve/HorizonCurve.hpp>
+#include <splx/curve/PiecewiseCurve.hpp>
+#include <Eigen/Dense>
+#include <vector>
+
+TEST_CASE("", "[HorizonCurve]") {
+    using Bez = splx::Bezier<double, 3>;
+
+    double double_eq_epsilon = 1e-13;
+
+    std::vector<Bez> pieces;
+    for(unsigned int i = 0; i < 20; i++) {
+        pieces.emplace_back(0.5 + (i % 3) * 0.25, Bez::ControlPoints{
+            {1.0 * i, 2, 3}, {3, 2.0 * i, 1}, {2, 2.3, -1.0 * i}, {-5, -5, 1.0 * i}
+        });
+    }
+
+    splx::HorizonCurve<double, 3> horizon;
+    REQUIRE(horizon.empty());
+    REQUIRE_THROWS_AS(horizon.popFront(), std::logic_error);
+    REQUIRE_THROWS_AS(horizon.eval(0, 0), std::logic_error);
+
+    // keep at most 5 pieces while sliding over all pieces. parameters are
+    // chosen away from piece boundaries, where pieces are discontinuous
+    std::size_t first = 0;
+    double startTime = 0;
+    for(std::size_t i = 0; i < pieces.size(); i++) {
+        horizon.pushBack(pieces[i]);
+        if(horizon.numPieces() > 5) {
+            startTime += pieces[first].maxParameter();
+            horizon.popFront();
+            first++;
+        }
+
+        splx::PiecewiseCurve<double, 3> expected;
+        for(std::size_t j = first; j <= i; j++) {
+            expected.addPiece(pieces[j]);
+        }
+
+        REQUIRE(horizon.numPieces() == i + 1 - first);
+        REQUIRE(std::abs(horizon.startTime() - startTime) < double_eq_epsilon);
+        REQUIRE(std::abs(horizon.maxParameter() - expected.maxParameter()) < double_eq_epsilon);
+        REQUIRE((horizon.front()[0] - pieces[first][0]).squaredNorm() == 0);
+        REQUIRE((horizon.back()[0] - pieces[i][0]).squaredNorm() == 0);
+
+        for(double u = 0.03; u <= expected.maxParameter(); u += 0.1) {
+            for(unsigned int k = 0; k < 3; k++) {
+                REQUIRE((horizon.eval(u, k) - expected.eval(u, k)).squaredNorm() < double_eq_epsilon);
+                REQUIRE((horizon.eval<splx::ClampPolicy>(u, k) - expected.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+            auto res = horizon.evalDerivatives(u, 2);
+            REQUIRE((res.col(1) - expected.eval(u, 1)).squaredNorm() < double_eq_epsilon);
+        }
+    }
+
+    SECTION("pushBack of own piece") {
+        // pieces of the curve are copied before a full ring buffer grows
+        splx::HorizonCurve<double, 3> copies;
+        copies.pushBack(pieces[1]);
+        for(unsigned int i = 1; i < 10; i++) {
+            if(i == 5) {
+                copies.popFront();
+                copies.pushBack(copies.front());
+            }
+            copies.pushBack(copies.back());
+        }
+
+        REQUIRE(copies.numPieces() == 10);
+        REQUIRE(std::abs(copies.maxParameter() - 10 * pieces[1].maxParameter()) < double_eq_epsilon);
+        for(std::size_t i = 0; i < copies.numPieces(); i++) {
+            REQUIRE(copies[i].numControlPoints() == 4);
+            for(std::size_t j = 0; j < 4; j++) {
+                REQUIRE((copies[i][j] - pieces[1][j]).squaredNorm() == 0);
+            }
+        }
+    }
+
+    SECTION("truncateAfter") {
+        const double maxParameter = horizon.maxParameter();
+        splx::PiecewiseCurve<double, 3> expected;
+        for(std::size_t i = 0; i < horizon.numPieces(); i++) {
+            expected.addPiece(horizon[i]);
+        }
+
+        const double u = horizon[0].maxParameter() + 0.3 * horizon[1].maxParameter();
+        horizon.truncateAfter(u);
+        REQUIRE(horizon.numPieces() == 2);
+        REQUIRE(std::abs(horizon.maxParameter() - u) < double_eq_epsilon);
+        for(double v = 0.03; v <= u; v += 0.05) {
+            for(unsigned int k = 0; k < 3; k++) {
+                REQUIRE((horizon.eval(v, k) - expected.eval(v, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+
+        REQUIRE_THROWS_AS(horizon.truncateAfter(maxParameter), std::domain_error);
+
+        horizon.truncateAfter(horizon[0].maxParameter());
+        REQUIRE(horizon.numPieces() == 1);
+
+        horizon.truncateAfter(0);
+        REQUIRE(horizon.empty());
+
+        horizon.pushBack(pieces[0]);
+        REQUIRE(horizon.maxParameter() == pieces[0].maxParameter());
+        REQUIRE((horizon.eval(0.2, 1) - pieces[0].eval(0.2, 1)).squaredNorm() < double_eq_epsilon);
+    }
+}
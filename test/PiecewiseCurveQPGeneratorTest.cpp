@@ -10,4 +10,339 @@
 
 TEST_CASE("construction test", "[PiecewiseCurveQPGenerator]") {
     splx::PiecewiseCurveQPGenerator<double, 3> generator;
-}
\ No newline at end of file
+}
+
+TEST_CASE("sparse integrated squared derivative cost", "[PiecewiseCurveQPGenerator]") {
+    splx::PiecewiseCurveQPGenerator<double, 3> generator;
+    generator.addBezier(8, 1.5);
+    generator.addBezier(6, 0.5);
+    generator.addBezier(8, 2);
+
+    for(unsigned int k = 0; k <= 4; k++) {
+        auto [Q, c] = generator.integratedSquaredDerivativeCost(k, 0.7);
+        REQUIRE(Q.rows() == generator.numDecisionVariables());
+        REQUIRE(Q.cols() == generator.numDecisionVariables());
+        REQUIRE(c.isZero());
+
+        // Q is the block diagonal of the piece costs
+        splx::Matrix<double> expected(Q.rows(), Q.cols());
+        expected.setZero();
+        splx::Index start = 0;
+        for(auto [ncpts, a] : {std::make_pair(8, 1.5), std::make_pair(6, 0.5), std::make_pair(8, 2.0)}) {
+            splx::BezierQPOperations<double, 3> operations(ncpts, a);
+            auto [Qs, cs] = operations.integratedSquaredDerivativeCost(k, 0.7);
+            expected.block(start, start, Qs.rows(), Qs.cols()) = Qs;
+            start += Qs.rows();
+        }
+
+        REQUIRE((splx::Matrix<double>(Q) - expected).norm() < 1e-9 * (1 + expected.norm()));
+        REQUIRE(Q.nonZeros() <= 3 * (8 * 8 + 6 * 6 + 8 * 8));
+    }
+}
+
+TEST_CASE("sparse constraints", "[PiecewiseCurveQPGenerator]") {
+    using Hyperplane = splx::Hyperplane<double, 3>;
+
+    splx::BezierQPOperations<double, 3> operations(6, 1.5);
+
+    auto constraints = operations.evalConstraint(0.4, 1, {1, 2, 3});
+    REQUIRE(constraints.size() == 3);
+    for(unsigned int d = 0; d < 3; d++) {
+        REQUIRE(constraints[d].coeff.size() == 18);
+        REQUIRE(constraints[d].coeff.nonZeros() <= 6);
+        REQUIRE((splx::Row<double>(constraints[d].coeff) - operations.evalBasisRow(d, 0.4, 1)).norm() < 1e-12);
+        REQUIRE(constraints[d].lb == d + 1);
+    }
+
+    Hyperplane hp(splx::VectorDIM<double, 3>(0, 0.6, 0.8), 2);
+    constraints = operations.hyperplaneConstraintAll(hp);
+    REQUIRE(constraints.size() == 6);
+    REQUIRE(constraints[2].coeff.nonZeros() == 2);
+    REQUIRE(constraints[2].coeff.coeff(6 + 2) == Approx(0.6));
+    REQUIRE(constraints[2].coeff.coeff(12 + 2) == Approx(0.8));
+
+    // dense rows are stored sparse
+    splx::Row<double> row(5);
+    row << 0, 1, 0, 0, 2;
+    splx::Constraint<double> constraint(row, 0, 1);
+    REQUIRE(constraint.coeff.nonZeros() == 2);
+    REQUIRE(splx::Row<double>(constraint.coeff) == row);
+    REQUIRE(constraint.denseCoeff() == row);
+}
+
+TEST_CASE("deferred assembly", "[PiecewiseCurveQPGenerator]") {
+    using VectorDIM = splx::VectorDIM<double, 3>;
+
+    splx::PiecewiseCurveQPGenerator<double, 3> generator;
+    generator.addBezier(8, 1.5);
+    generator.addBezier(6, 0.5);
+    generator.addBezier(8, 2);
+    generator.deferAssembly(true);
+    REQUIRE(generator.deferAssembly());
+
+    generator.addIntegratedSquaredDerivativeCost(2, 0.5);
+    generator.addIntegratedSquaredDerivativeCost(3, 1);
+    generator.addEvalCost(1.7, 0, VectorDIM(1, 2, 3), 10);
+    generator.addEvalConstraint(0, 0, VectorDIM(0, 0, 0));
+    generator.addContinuityConstraint(0, 1);
+    generator.addContinuityConstraint(1, 1);
+
+    // deferred Q is the sum of the block diagonal costs
+    auto [Q, c] = generator.deferredCost();
+    splx::Matrix<double> expected = splx::Matrix<double>(generator.integratedSquaredDerivativeCost(2, 0.5).first)
+                                  + splx::Matrix<double>(generator.integratedSquaredDerivativeCost(3, 1).first);
+    splx::BezierQPOperations<double, 3> operations(6, 0.5);
+    auto [Qs, cs] = operations.evalCost(0.2, 0, VectorDIM(1, 2, 3), 10);
+    expected.block(24, 24, 18, 18) += Qs;
+
+    REQUIRE((splx::Matrix<double>(Q) - expected).norm() < 1e-9 * (1 + expected.norm()));
+    REQUIRE((c.segment(24, 18) - cs).norm() < 1e-9 * (1 + cs.norm()));
+    REQUIRE(c.head(24).isZero());
+
+    REQUIRE(generator.deferredConstraints().size() == 9);
+    for(const auto& constraint: generator.deferredConstraints()) {
+        REQUIRE(constraint.coeff.size() == generator.numDecisionVariables());
+    }
+
+    generator.finalize();
+    REQUIRE(generator.deferredConstraints().empty());
+    REQUIRE(generator.deferredCost().first.nonZeros() == 0);
+
+    // changing pieces drops deferred contributions
+    generator.addEvalConstraint(0, 0, VectorDIM(0, 0, 0));
+    generator.addBezier(4, 1);
+    REQUIRE(generator.deferredConstraints().empty());
+}
+
+TEST_CASE("cached integrated squared derivative cost", "[PiecewiseCurveQPGenerator]") {
+    for(unsigned int ncpts : {2, 5, 8}) {
+        for(double a : {0.3, 1.0, 2.5}) {
+            splx::BezierQPOperations<double, 2> operations(ncpts, a);
+            for(unsigned int k = 0; k <= 4; k++) {
+                auto [Q, c] = operations.integratedSquaredDerivativeCost(k, 0.5);
+
+                // integral of the products of bernstein derivatives over [0, a]
+                splx::Matrix<double> expected(ncpts, ncpts);
+                expected.setZero();
+                if(k < ncpts) {
+                    auto bern = splx::internal::bezier::bernsteinCoefficientMatrix<double>(ncpts - 1, a, k);
+                    splx::Matrix<double> SQI(ncpts, ncpts);
+                    for(unsigned int i = 0; i < ncpts; i++) {
+                        for(unsigned int j = 0; j < ncpts; j++) {
+                            SQI(i, j) = std::pow(a, i + j + 1) / (i + j + 1);
+                        }
+                    }
+                    expected = bern * SQI * bern.transpose();
+                }
+
+                REQUIRE((Q.block(0, 0, ncpts, ncpts) - expected).norm() <= 1e-9 * (1 + expected.norm()));
+                REQUIRE((Q.block(ncpts, ncpts, ncpts, ncpts) - expected).norm() <= 1e-9 * (1 + expected.norm()));
+                REQUIRE(Q.block(0, ncpts, ncpts, ncpts).isZero());
+            }
+        }
+    }
+
+    REQUIRE(&splx::internal::bezier::bernsteinDerivativeGramMatrix<double>(4, 2)
+            == &splx::internal::bezier::bernsteinDerivativeGramMatrix<double>(4, 2));
+}
+
+TEST_CASE("axis separable problems", "[PiecewiseCurveQPGenerator]") {
+    using VectorDIM = splx::VectorDIM<double, 3>;
+    using Hyperplane = splx::Hyperplane<double, 3>;
+
+    splx::PiecewiseCurveQPGenerator<double, 3> generator;
+    generator.addBezier(5, 1.5);
+    generator.addBezier(4, 0.5);
+    generator.deferAssembly(true);
+
+    generator.addIntegratedSquaredDerivativeCost(2, 1);
+    generator.addEvalConstraint(0, 0, VectorDIM(1, 2, 3));
+    generator.addContinuityConstraint(0, 1);
+    generator.addHyperplaneConstraintAll(Hyperplane(VectorDIM(0, 1, 0), 4));
+    generator.addBoundingBoxConstraint(splx::AlignedBox<double, 3>(VectorDIM(-5, -5, -5), VectorDIM(5, 5, 5)));
+    REQUIRE(generator.isAxisSeparable());
+
+    auto problems = generator.axisProblems();
+    REQUIRE(problems.size() == 3);
+
+    // axis index a of dimension d is decision variable full(d, a) of the full problem
+    auto full = [](unsigned int d, Eigen::Index a) {
+        return a < 5 ? d * 5 + a : 15 + d * 4 + (a - 5);
+    };
+    auto [Q, c] = generator.deferredCost();
+    const auto& constraints = generator.deferredConstraints();
+    Eigen::Index numRows = 0;
+    for(unsigned int d = 0; d < 3; d++) {
+        const auto& problem = problems[d];
+        REQUIRE(problem.num_vars() == 9);
+        for(Eigen::Index a = 0; a < 9; a++) {
+            REQUIRE(problem.c()(a) == c(full(d, a)));
+            for(Eigen::Index b = 0; b < 9; b++) {
+                REQUIRE(problem.Q()(a, b) == Q.coeff(full(d, a), full(d, b)));
+            }
+        }
+
+        // rows of the constraints whose variables are of dimension d, in order
+        Eigen::Index r = 0;
+        for(const auto& constraint: constraints) {
+            bool ofDimension = false;
+            for(Eigen::Index a = 0; a < 9; a++) {
+                ofDimension = ofDimension || constraint.coeff.coeff(full(d, a)) != 0;
+            }
+            if(!ofDimension) {
+                continue;
+            }
+
+            REQUIRE(r < problem.A().rows());
+            for(Eigen::Index a = 0; a < 9; a++) {
+                REQUIRE(problem.A()(r, a) == constraint.coeff.coeff(full(d, a)));
+            }
+            REQUIRE(problem.lb()(r) == constraint.lb);
+            REQUIRE(problem.ub()(r) == constraint.ub);
+            r++;
+        }
+        REQUIRE(problem.A().rows() == r);
+        numRows += r;
+    }
+    REQUIRE(numRows == static_cast<Eigen::Index>(constraints.size()));
+
+    // axis solutions are merged back into the control points of each dimension
+    std::vector<splx::Vector<double>> solns;
+    for(unsigned int d = 0; d < 3; d++) {
+        solns.push_back(splx::Vector<double>::LinSpaced(9, 10 * d, 10 * d + 8));
+    }
+    const auto& constGenerator = generator;
+    auto curve = constGenerator.extractCurve(solns);
+    REQUIRE(curve.numPieces() == 2);
+    REQUIRE(curve.pieceControlPoints(0).col(1) == VectorDIM(1, 11, 21));
+    REQUIRE(curve.pieceControlPoints(1).col(3) == VectorDIM(8, 18, 28));
+    REQUIRE_THROWS_AS(generator.extractCurve(std::vector<splx::Vector<double>>(2, solns[0])), std::domain_error);
+
+    generator.addHyperplaneConstraintAll(Hyperplane(VectorDIM(0.6, 0.8, 0), 4));
+    REQUIRE_FALSE(generator.isAxisSeparable());
+    REQUIRE_THROWS_AS(generator.axisProblems(), std::logic_error);
+
+    // deferred contributions no longer describe the problem after finalize
+    generator.resetProblem();
+    generator.addIntegratedSquaredDerivativeCost(2, 1);
+    generator.finalize();
+    REQUIRE_THROWS_AS(generator.isAxisSeparable(), std::logic_error);
+    REQUIRE_THROWS_AS(generator.axisProblems(), std::logic_error);
+
+    generator.resetProblem();
+    REQUIRE(generator.isAxisSeparable());
+    generator.deferAssembly(false);
+    REQUIRE_THROWS_AS(generator.isAxisSeparable(), std::logic_error);
+    REQUIRE_THROWS_AS(generator.axisProblems(), std::logic_error);
+}
+
+TEST_CASE("continuity by elimination", "[PiecewiseCurveQPGenerator]") {
+    using VectorDIM = splx::VectorDIM<double, 3>;
+
+    splx::PiecewiseCurveQPGenerator<double, 3> generator;
+    generator.addBezier(8, 1.5);
+    generator.addBezier(8, 0.5);
+    generator.addBezier(6, 2);
+    generator.eliminateContinuity(3);
+    REQUIRE(generator.eliminatesContinuity());
+    REQUIRE(generator.deferAssembly());
+
+    auto map = generator.continuityEliminationMap();
+    REQUIRE(map.rows() == generator.numDecisionVariables());
+    REQUIRE(map.cols() == generator.numDecisionVariables() - 2 * 3 * 4);
+
+    // any reduced solution gives a curve that is continuous up to the third derivative
+    splx::Vector<double> reduced = splx::Vector<double>::Random(map.cols());
+    auto curve = generator.extractCurve(reduced);
+    for(unsigned int k = 0; k <= 3; k++) {
+        for(double joint : {1.5, 2.0}) {
+            VectorDIM left = curve.eval(joint - 1e-9, k);
+            VectorDIM right = curve.eval(joint + 1e-9, k);
+            REQUIRE((left - right).norm() < 1e-5 * (1 + left.norm()));
+        }
+    }
+    REQUIRE((curve.eval(2.1, 4) - curve.eval(1.9, 4)).norm() > 1e-3);
+    REQUIRE_THROWS_AS(generator.extractCurve(splx::Vector<double>(generator.numDecisionVariables())), std::domain_error);
+
+    // continuity rows are not added when they are eliminated
+    generator.addContinuityConstraint(0, 2);
+    REQUIRE(generator.deferredConstraints().empty());
+    REQUIRE_THROWS_AS(generator.axisProblems(), std::logic_error);
+
+    generator.eliminateContinuity(6);
+    REQUIRE_THROWS_AS(generator.continuityEliminationMap(), std::domain_error);
+
+    generator.deferAssembly(false);
+    REQUIRE_FALSE(generator.eliminatesContinuity());
+}
+
+TEST_CASE("finalize with continuity elimination", "[PiecewiseCurveQPGenerator]") {
+    using VectorDIM = splx::VectorDIM<double, 2>;
+    using Matrix = splx::Matrix<double>;
+    using Vector = splx::Vector<double>;
+
+    splx::PiecewiseCurveQPGenerator<double, 2> generator;
+    generator.addBezier(4, 1);
+    generator.addBezier(4, 0.5);
+    generator.eliminateContinuity(1);
+    REQUIRE(generator.numReducedVariables() == 16 - 2 * 2);
+
+    // the map is computed once until pieces change
+    const Matrix M = generator.continuityEliminationMap();
+    REQUIRE(&generator.continuityEliminationMap() == &generator.continuityEliminationMap());
+
+    generator.addIntegratedSquaredDerivativeCost(2, 1);
+    generator.addEvalConstraint(1.2, 0, VectorDIM(1, 2));
+    generator.addBoundingBoxConstraint(splx::AlignedBox<double, 2>(VectorDIM(-5, -4), VectorDIM(5, 4)));
+    auto [Q1, c1] = generator.deferredCost();
+    const auto constraints1 = generator.deferredConstraints();
+    generator.finalize();
+
+    const auto& problem = generator.getProblem();
+    REQUIRE(problem.num_vars() == 12);
+    REQUIRE((problem.Q() - M.transpose() * Matrix(Q1) * M).norm() < 1e-9);
+    REQUIRE((problem.c() - M.transpose() * c1).norm() < 1e-9);
+
+    // rows of the constraints, then rows of the limits of eliminated
+    // variables. variables 8 and 12 are copies of reduced variables, whose
+    // limits they tighten instead.
+    REQUIRE(problem.A().rows() == static_cast<Eigen::Index>(constraints1.size()) + 2);
+    for(std::size_t i = 0; i < constraints1.size(); i++) {
+        REQUIRE((problem.A().row(i) - constraints1[i].denseCoeff() * M).norm() < 1e-12);
+    }
+    const Eigen::Index eliminated[] = {9, 13};
+    for(unsigned int i = 0; i < 2; i++) {
+        const Eigen::Index r = constraints1.size() + i;
+        REQUIRE((problem.A().row(r) - M.row(eliminated[i])).norm() < 1e-12);
+        REQUIRE(problem.lb()(r) == (eliminated[i] < 12 ? -5 : -4));
+        REQUIRE(problem.ub()(r) == (eliminated[i] < 12 ? 5 : 4));
+    }
+
+    // a second finalize adds to the reduced problem
+    generator.addEvalCost(0.3, 1, VectorDIM(2, 1), 3);
+    generator.addHyperplaneConstraintAll(splx::Hyperplane<double, 2>(VectorDIM(0.6, 0.8), 4));
+    auto [Q2, c2] = generator.deferredCost();
+    const auto constraints2 = generator.deferredConstraints();
+    generator.finalize();
+
+    REQUIRE(generator.getProblem().num_vars() == 12);
+    REQUIRE((problem.Q() - M.transpose() * Matrix(Q1 + Q2) * M).norm() < 1e-9);
+    REQUIRE((problem.c() - M.transpose() * Vector(c1 + c2)).norm() < 1e-9);
+    REQUIRE(problem.A().rows() == static_cast<Eigen::Index>(constraints1.size() + 2 + constraints2.size()));
+    for(std::size_t i = 0; i < constraints2.size(); i++) {
+        const Eigen::Index r = constraints1.size() + 2 + i;
+        REQUIRE((problem.A().row(r) - constraints2[i].denseCoeff() * M).norm() < 1e-12);
+        REQUIRE(problem.ub()(r) == constraints2[i].ub);
+    }
+
+    // the reduced variables can not change once the problem has contributions
+    REQUIRE_THROWS_AS(generator.eliminateContinuity(2), std::logic_error);
+    REQUIRE_THROWS_AS(generator.deferAssembly(false), std::logic_error);
+    generator.resetProblem();
+    generator.eliminateContinuity(2);
+    REQUIRE(generator.numReducedVariables() == 16 - 2 * 3);
+
+    generator.addBezier(5, 1);
+    REQUIRE(generator.continuityEliminationMap().rows() == 26);
+    REQUIRE(generator.numReducedVariables() == 26 - 2 * 2 * 3);
+}
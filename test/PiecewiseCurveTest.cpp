@@ -3,7 +3,9 @@
 #include <splx/curve/Bezier.hpp>
 #include <splx/curve/PiecewiseCurve.hpp>
 #include <Eigen/Dense>
+#include <cmath>
 #include <iostream>
+#include <random>
 
 TEST_CASE("", "[PiecewiseCurve]") {
 
@@ -40,4 +42,385 @@ TEST_CASE("", "[PiecewiseCurve]") {
 
     REQUIRE((piecewiseCurve.eval(2.123616263123, 5) - VectorDIM{9.831787628214174, 2.5970117330035167, -9.036818965112952}).squaredNorm() < double_eq_epsilon);
     REQUIRE((piecewiseCurve.eval(4.91273162413, 6) - VectorDIM{-133.52625000000006, 37.698749999999976, -10.12499999999995}).squaredNorm() < double_eq_epsilon);
-}
\ No newline at end of file
+
+    SECTION("evalDerivatives") {
+        for(double u : {0.0, 2.1, 3.5, 3.7, 5.5}) {
+            auto res = piecewiseCurve.evalDerivatives(u, 4);
+            REQUIRE(res.cols() == 5);
+            for(unsigned int k = 0; k <= 4; k++) {
+                REQUIRE((res.col(k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+
+        REQUIRE_THROWS_AS(piecewiseCurve.evalDerivatives(5.50000001, 2), std::domain_error);
+    }
+
+    SECTION("evalMany") {
+        using Vector = splx::PiecewiseCurve<double, 3>::Vector;
+        using MatrixDIMX = splx::PiecewiseCurve<double, 3>::MatrixDIMX;
+
+        Vector sorted = Vector::LinSpaced(101, 0, 5.5);
+        Vector unsorted(7);
+        unsorted << 4.9, 0.3, 3.5, 5.5, 0, 3.7, 2.1;
+
+        for(unsigned int k = 0; k < 7; k++) {
+            MatrixDIMX res = piecewiseCurve.evalMany(sorted, k);
+            for(Eigen::Index i = 0; i < sorted.size(); i++) {
+                REQUIRE((res.col(i) - piecewiseCurve.eval(sorted(i), k)).squaredNorm() < double_eq_epsilon);
+            }
+
+            res = piecewiseCurve.evalMany(unsorted, k);
+            for(Eigen::Index i = 0; i < unsorted.size(); i++) {
+                REQUIRE((res.col(i) - piecewiseCurve.eval(unsorted(i), k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+
+        unsorted(2) = 5.50000001;
+        REQUIRE_THROWS_AS(piecewiseCurve.evalMany(unsorted, 0), std::domain_error);
+    }
+
+    SECTION("setPiece") {
+        splx::Bezier<double, 3> piece {1.5, {{1, 1, 1}, {2, 0, 2}, {0, 3, -1}}};
+        splx::Bezier<double, 3> secondPiece = piecewiseCurve[1];
+
+        piecewiseCurve.setPiece(0, piece);
+        REQUIRE(piecewiseCurve.numPieces() == 2);
+        REQUIRE(piecewiseCurve.maxParameter() == 3.5);
+        REQUIRE(piecewiseCurve.pieceControlPoints(0).cols() == 3);
+        REQUIRE(piecewiseCurve.pieceControlPoints(1).cols() == 7);
+
+        for(unsigned int k = 0; k < 4; k++) {
+            REQUIRE((piecewiseCurve.eval(0.7, k) - piece.eval(0.7, k)).squaredNorm() < double_eq_epsilon);
+            REQUIRE((piecewiseCurve.eval(2.5, k) - secondPiece.eval(1, k)).squaredNorm() < double_eq_epsilon);
+        }
+
+        REQUIRE(piecewiseCurve[0].numControlPoints() == 3);
+        REQUIRE((piecewiseCurve[0][2] - piece[2]).squaredNorm() == 0);
+        REQUIRE_THROWS_AS(piecewiseCurve.pieceControlPoints(2), std::domain_error);
+    }
+
+    SECTION("piece views") {
+        auto view = piecewiseCurve[1];
+        REQUIRE(view.maxParameter() == 2);
+        REQUIRE(view.numControlPoints() == 7);
+        REQUIRE(view.degree() == 6);
+        REQUIRE(view[0].data() == piecewiseCurve.pieceControlPoints(1).data());
+        REQUIRE(view.controlPointMatrix().data() == piecewiseCurve.pieceControlPoints(1).data());
+        REQUIRE(view.boundingBox().isApprox(piecewiseCurve.pieceBoundingBox(1)));
+        REQUIRE_THROWS_AS(view.eval(2.00000001, 0), std::domain_error);
+        REQUIRE((view.eval<splx::ClampPolicy>(3, 1) - view.eval(2, 1)).squaredNorm() == 0);
+
+        splx::Bezier<double, 3> copy = piecewiseCurve.getPiece(1);
+        REQUIRE(copy.maxParameter() == 2);
+        REQUIRE(copy.numControlPoints() == 7);
+        for(unsigned int k = 0; k < 4; k++) {
+            REQUIRE((view.eval(1.3, k) - copy.eval(1.3, k)).squaredNorm() < double_eq_epsilon);
+        }
+
+        auto bezptr = std::make_shared<splx::Bezier<double, 3>>(copy);
+        piecewiseCurve.setPiece(1, bezptr);
+        (*bezptr)[0] = VectorDIM(100, 100, 100);
+        REQUIRE((piecewiseCurve[1][0] - copy[0]).squaredNorm() == 0);
+    }
+
+    SECTION("cursor") {
+        auto cursor = piecewiseCurve.cursor();
+        for(double u = 0; u <= 5.5; u += 0.05) {
+            for(unsigned int k = 0; k < 3; k++) {
+                REQUIRE((cursor.eval(u, k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+        REQUIRE(cursor.pieceIndex() == 1);
+
+        for(double u : {3.5, 0.2, 5.5, 3.6, 0.0}) {
+            auto res = cursor.evalDerivatives(u, 3);
+            for(unsigned int k = 0; k <= 3; k++) {
+                REQUIRE((res.col(k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+        REQUIRE(cursor.pieceIndex() == 0);
+
+        REQUIRE_THROWS_AS(cursor.eval(5.50000001, 0), std::domain_error);
+    }
+
+    SECTION("many pieces with retiming") {
+        splx::PiecewiseCurve<double, 3> curve;
+        std::vector<splx::Bezier<double, 3>> pieces;
+        for(unsigned int i = 0; i < 37; i++) {
+            pieces.emplace_back(0.5 + (i % 5) * 0.25, splx::Bezier<double, 3>::ControlPoints{
+                {1.0 * i, 2, 3}, {3, 2.0 * i, 1}, {2, 2.3, -1.0 * i}, {-5, -5, -5}
+            });
+            curve.addPiece(pieces.back());
+        }
+
+        for(unsigned int i = 0; i < 37; i += 3) {
+            pieces[i].maxParameter(0.1 * i);
+            curve.setPieceMaxParameter(i, 0.1 * i);
+        }
+
+        double start = 0;
+        for(unsigned int i = 0; i < 37; i++) {
+            double u = start + 0.5 * pieces[i].maxParameter();
+            REQUIRE((curve.eval(u, 1) - pieces[i].eval(0.5 * pieces[i].maxParameter(), 1)).squaredNorm() < double_eq_epsilon);
+            start += pieces[i].maxParameter();
+        }
+        REQUIRE(std::abs(curve.maxParameter() - start) < double_eq_epsilon);
+
+        auto cursor = curve.cursor();
+        for(double u = 0; u <= curve.maxParameter(); u += 0.3) {
+            REQUIRE((cursor.eval(u, 0) - curve.eval(u, 0)).squaredNorm() < double_eq_epsilon);
+        }
+
+        // small steps walk the running piece bounds one piece at a time
+        cursor.reset();
+        for(double u = 0; u <= curve.maxParameter(); u += 0.01) {
+            REQUIRE((cursor.eval(u, 1) - curve.eval(u, 1)).squaredNorm() < double_eq_epsilon);
+        }
+        REQUIRE((cursor.eval(curve.maxParameter(), 0) - curve.eval(curve.maxParameter(), 0)).squaredNorm() < double_eq_epsilon);
+        REQUIRE(cursor.pieceIndex() == 36);
+
+        REQUIRE_THROWS_AS(curve.setPieceMaxParameter(37, 1), std::domain_error);
+        REQUIRE_THROWS_AS(curve.setPieceMaxParameter(0, -1), std::domain_error);
+    }
+
+    SECTION("long retiming does not drift") {
+        splx::PiecewiseCurve<double, 3> curve;
+        for(unsigned int i = 0; i < 37; i++) {
+            curve.addPiece(splx::Bezier<double, 3>{1, {{1.0 * i, 2, 3}, {3, 2.0 * i, 1}, {-5, -5, -5}}});
+        }
+
+        // retime pieces to durations of very different magnitudes
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<unsigned int> pieceDistribution(0, 36);
+        std::uniform_real_distribution<double> durationDistribution(0.5, 1.5);
+        const double scales[] = {1e-3, 1, 1e3};
+        for(unsigned int iteration = 0; iteration < 200000; iteration++) {
+            curve.setPieceMaxParameter(
+                pieceDistribution(generator),
+                scales[iteration % 3] * durationDistribution(generator)
+            );
+        }
+
+        // same durations set once
+        splx::PiecewiseCurve<double, 3> fresh;
+        for(unsigned int i = 0; i < 37; i++) {
+            fresh.addPiece(curve[i]);
+        }
+
+        REQUIRE(curve.maxParameter() == fresh.maxParameter());
+        for(double u = 0; u <= curve.maxParameter(); u += curve.maxParameter() / 997) {
+            REQUIRE(curve.eval(u, 0) == fresh.eval(u, 0));
+        }
+        double start = 0;
+        for(unsigned int i = 0; i < 37; i++) {
+            start += curve.pieceMaxParameter(i);
+        }
+        REQUIRE(std::abs(curve.maxParameter() - start) <= 1e-12 * start);
+    }
+
+    SECTION("uniform durations") {
+        REQUIRE(!piecewiseCurve.hasUniformDurations());
+
+        splx::PiecewiseCurve<double, 3> curve;
+        std::vector<splx::Bezier<double, 3>> pieces;
+        for(unsigned int i = 0; i < 25; i++) {
+            pieces.emplace_back(0.1, splx::Bezier<double, 3>::ControlPoints{
+                {1.0 * i, 2, 3}, {3, 2.0 * i, 1}, {2, 2.3, -1.0 * i}
+            });
+            curve.addPiece(pieces.back());
+        }
+        REQUIRE(curve.hasUniformDurations());
+
+        for(unsigned int i = 0; i < 25; i++) {
+            for(double t : {0.01, 0.05, 0.09}) {
+                REQUIRE((curve.eval(i * 0.1 + t, 1) - pieces[i].eval(t, 1)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+        REQUIRE((curve.eval(0, 0) - pieces[0].eval(0, 0)).squaredNorm() < double_eq_epsilon);
+        REQUIRE_NOTHROW(curve.eval(curve.maxParameter(), 0));
+
+        pieces[3].maxParameter(0.2);
+        curve.setPieceMaxParameter(3, 0.2);
+        REQUIRE(!curve.hasUniformDurations());
+        REQUIRE((curve.eval(0.45, 0) - pieces[3].eval(0.15, 0)).squaredNorm() < double_eq_epsilon);
+
+        curve.setPieceMaxParameter(3, 0.1);
+        REQUIRE(curve.hasUniformDurations());
+
+        curve.setPieceMaxParameter(0, 0.2);
+        REQUIRE(!curve.hasUniformDurations());
+
+        // retiming every piece to the new duration of piece 0
+        for(unsigned int i = 1; i < 25; i++) {
+            REQUIRE(!curve.hasUniformDurations());
+            pieces[i].maxParameter(0.2);
+            curve.setPieceMaxParameter(i, 0.2);
+        }
+        REQUIRE(curve.hasUniformDurations());
+        REQUIRE((curve.eval(0.45, 0) - pieces[2].eval(0.05, 0)).squaredNorm() < double_eq_epsilon);
+    }
+
+    SECTION("high degree evalMany and sample") {
+        using MatrixDIMX = splx::PiecewiseCurve<double, 3>::MatrixDIMX;
+
+        // degree 20 pieces with short, unit and long durations
+        splx::PiecewiseCurve<double, 3> curve;
+        for(double a : {0.05, 1.0, 10.0}) {
+            splx::Bezier<double, 3>::ControlPoints cpts;
+            for(unsigned int i = 0; i <= 20; i++) {
+                cpts.emplace_back(std::sin(i + a), std::cos(2.0 * i), 0.1 * i * i);
+            }
+            curve.addPiece(splx::Bezier<double, 3>(a, cpts));
+        }
+
+        const double dt = 0.013;
+        const Eigen::Index N = curve.numSamples(0, curve.maxParameter(), dt);
+        MatrixDIMX samples = curve.sample(0, curve.maxParameter(), dt, 2);
+        splx::Vector<double> us(N);
+        for(Eigen::Index i = 0; i < N; i++) {
+            us(i) = std::min(i * dt, curve.maxParameter());
+        }
+
+        for(unsigned int k = 0; k <= 2; k++) {
+            MatrixDIMX many = curve.evalMany(us, k);
+            for(Eigen::Index i = 0; i < N; i++) {
+                const auto expected = curve.eval(us(i), k);
+                const double tolerance = 1e-10 * (1 + expected.norm());
+                REQUIRE((many.col(i) - expected).norm() < tolerance);
+                REQUIRE((samples.col(k * N + i) - expected).norm() < tolerance);
+            }
+        }
+    }
+
+    SECTION("sample") {
+        using MatrixDIMX = splx::PiecewiseCurve<double, 3>::MatrixDIMX;
+
+        const double dt = 0.01;
+        const Eigen::Index N = piecewiseCurve.numSamples(0.2, 5.5, dt);
+        REQUIRE(N == 531);
+
+        for(unsigned int numThreads : {1, 4}) {
+            MatrixDIMX res = piecewiseCurve.sample(0.2, 5.5, dt, 3, numThreads);
+            REQUIRE(res.cols() == N * 4);
+            for(Eigen::Index i = 0; i < N; i++) {
+                const double u = std::min(0.2 + i * dt, 5.5);
+                for(unsigned int k = 0; k <= 3; k++) {
+                    REQUIRE((res.col(k * N + i) - piecewiseCurve.eval(u, k)).squaredNorm() < 1e-10);
+                }
+            }
+        }
+
+        // (0.3 - 0) / 0.1 rounds below 3, t1 must still be sampled
+        REQUIRE((0.3 - 0.0) / 0.1 < 3);
+        REQUIRE(piecewiseCurve.numSamples(0, 0.3, 0.1) == 4);
+        MatrixDIMX last = piecewiseCurve.sample(0, 0.3, 0.1, 0);
+        REQUIRE(last.cols() == 4);
+        REQUIRE((last.col(3) - piecewiseCurve.eval(0.3, 0)).squaredNorm() < double_eq_epsilon);
+        REQUIRE(piecewiseCurve.numSamples(0, 0.29, 0.1) == 3);
+
+        MatrixDIMX single = piecewiseCurve.sample(3.5, 3.5, dt, 0);
+        REQUIRE(single.cols() == 1);
+        REQUIRE((single.col(0) - piecewiseCurve.eval(3.5, 0)).squaredNorm() < double_eq_epsilon);
+
+        MatrixDIMX wrongSize(3, 2);
+        REQUIRE_THROWS_AS(piecewiseCurve.sample(0, 1, dt, 0, wrongSize), std::domain_error);
+        REQUIRE_THROWS_AS(piecewiseCurve.sample(0, 5.6, dt, 0), std::domain_error);
+        REQUIRE_THROWS_AS(piecewiseCurve.sample(1, 0, dt, 0), std::domain_error);
+        REQUIRE_THROWS_AS(piecewiseCurve.sample(0, 1, 0, 0), std::domain_error);
+    }
+
+    SECTION("arc length") {
+        // x = (u/2)^2 * 5 on the first piece, then a line of length 5
+        splx::PiecewiseCurve<double, 3> line;
+        line.addPiece(splx::Bezier<double, 3>{2, {{0, 0, 0}, {0, 0, 0}, {5, 0, 0}}});
+        line.addPiece(splx::Bezier<double, 3>{1, {{5, 0, 0}, {8, 4, 0}}});
+
+        REQUIRE(std::abs(line.arcLength() - 10) < 1e-12);
+        REQUIRE(std::abs(line.arcLength(1) - 1.25) < 1e-12);
+        REQUIRE(std::abs(line.arcLength(2.5) - 7.5) < 1e-12);
+        REQUIRE(std::abs(line.parameterAtArcLength(1.25) - 1) < 1e-10);
+        REQUIRE(std::abs(line.parameterAtArcLength(7.5) - 2.5) < 1e-10);
+        REQUIRE(line.parameterAtArcLength(0) == 0);
+        REQUIRE(std::abs(line.parameterAtArcLength(10) - 3) < 1e-10);
+
+        for(double u = 0; u <= piecewiseCurve.maxParameter(); u += 0.05) {
+            const double s = piecewiseCurve.arcLength(u);
+            REQUIRE(std::abs(piecewiseCurve.parameterAtArcLength(s) - u) < 1e-8);
+        }
+
+        splx::PiecewiseCurve<double, 3>::Vector ss(3);
+        ss << 0.5, 2, 9;
+        auto us = line.parametersAtArcLengths(ss);
+        for(Eigen::Index i = 0; i < ss.size(); i++) {
+            REQUIRE(us(i) == line.parameterAtArcLength(ss(i)));
+        }
+
+        line.setPieceMaxParameter(1, 2);
+        REQUIRE(std::abs(line.arcLength(3) - 7.5) < 1e-12);
+
+        REQUIRE_THROWS_AS(line.parameterAtArcLength(10.1), std::domain_error);
+        REQUIRE_THROWS_AS(line.parameterAtArcLength(-0.1), std::domain_error);
+        REQUIRE_THROWS_AS(line.arcLength(4.1), std::domain_error);
+    }
+
+    SECTION("bounding volumes") {
+        using AlignedBox = splx::PiecewiseCurve<double, 3>::AlignedBox;
+
+        // piece i is a segment from (i, 0, 0) to (i + 1, 0, 0)
+        splx::PiecewiseCurve<double, 3> curve;
+        for(unsigned int i = 0; i < 21; i++) {
+            curve.addPiece(splx::Bezier<double, 3>{1, {VectorDIM(i, 0, 0), VectorDIM(i + 1, 0, 0)}});
+        }
+
+        REQUIRE(curve.boundingBox().min() == VectorDIM(0, 0, 0));
+        REQUIRE(curve.boundingBox().max() == VectorDIM(21, 0, 0));
+        REQUIRE(curve.pieceBoundingBox(4).min() == VectorDIM(4, 0, 0));
+
+        auto hits = curve.piecesIntersecting(AlignedBox(VectorDIM(4.5, -1, -1), VectorDIM(6.5, 1, 1)));
+        REQUIRE(hits == std::vector<std::size_t>{4, 5, 6});
+
+        hits = curve.piecesIntersecting(AlignedBox(VectorDIM(4.5, 1, -1), VectorDIM(6.5, 2, 1)));
+        REQUIRE(hits.empty());
+
+        hits = curve.piecesNear(VectorDIM(10.5, 0.5, 0), 0.6);
+        REQUIRE(hits == std::vector<std::size_t>{10});
+
+        // setting a piece refits the hierarchy
+        curve.setPiece(10, splx::Bezier<double, 3>{1, {VectorDIM(10, 0, 0), VectorDIM(10, 5, 0), VectorDIM(11, 0, 0)}});
+        REQUIRE(curve.boundingBox().max() == VectorDIM(21, 5, 0));
+        hits = curve.piecesIntersecting(AlignedBox(VectorDIM(4.5, 1, -1), VectorDIM(16.5, 2, 1)));
+        REQUIRE(hits == std::vector<std::size_t>{10});
+
+        // adding a piece rebuilds the hierarchy
+        curve.addPiece(splx::Bezier<double, 3>{1, {VectorDIM(21, 0, 0), VectorDIM(21, 3, 0)}});
+        hits = curve.piecesNear(VectorDIM(21, 3, 0), 0.1);
+        REQUIRE(hits == std::vector<std::size_t>{21});
+        REQUIRE_THROWS_AS(curve.pieceBoundingBox(22), std::domain_error);
+    }
+
+    SECTION("emplacePiece") {
+        splx::PiecewiseCurve<double, 3> curve;
+        curve.reserve(2, 9);
+
+        Eigen::Matrix<double, 3, Eigen::Dynamic> cpts = piecewiseCurve.pieceControlPoints(0);
+        curve.emplacePiece(3.5, cpts);
+        curve.emplacePiece(2, piecewiseCurve.pieceControlPoints(1));
+
+        REQUIRE(curve.numPieces() == 2);
+        for(double u = 0; u <= 5.5; u += 0.05) {
+            for(unsigned int k = 0; k <= 3; k++) {
+                REQUIRE((curve.eval(u, k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+        REQUIRE(curve.pieceBoundingBox(1).min() == piecewiseCurve.pieceBoundingBox(1).min());
+        REQUIRE(curve.pieceBoundingBox(1).max() == piecewiseCurve.pieceBoundingBox(1).max());
+
+        // rows of a transposed solution block are control points
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> soln = cpts.transpose();
+        curve.emplacePiece(1, soln.transpose());
+        REQUIRE((curve.eval(6.5, 0) - piecewiseCurve.eval(3.5, 0)).squaredNorm() < double_eq_epsilon);
+
+        REQUIRE_THROWS_AS(curve.emplacePiece(-1, cpts), std::domain_error);
+        REQUIRE_THROWS_AS(curve.emplacePiece(1, soln), std::domain_error);
+    }
+}
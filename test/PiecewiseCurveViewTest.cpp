@@ -0,0 +1,132 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <splx/curve/Bezier.hpp>
+#include <splx/curve/PiecewiseCurve.hpp>
+#include <splx/curve/PiecewiseCurveView.hpp>
+#include <splx/io/binary.hpp>
+#include <splx/io/MappedFile.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+TEST_CASE("", "[PiecewiseCurveView]") {
+    double double_eq_epsilon = 1e-13;
+
+    splx::PiecewiseCurve<double, 3> piecewiseCurve;
+    piecewiseCurve.addPiece(splx::Bezier<double, 3>{3.5, {{1, 2, 3}, {3, 2, 1}, {2, 2.3, 3.4}, {3, 2.2, 3.1}, {-5, -5, -5}}});
+    piecewiseCurve.addPiece(splx::Bezier<double, 3>{2, {{-5, -5, -5}, {3, 2, 1}, {2, 2.3, 3.4}}});
+    piecewiseCurve.addPiece(splx::Bezier<double, 3>{0.5, {{2, 2.3, 3.4}, {-2.11, -.231, 1.2}}});
+
+    const std::vector<char> buffer = splx::io::toBinary(piecewiseCurve);
+
+    SECTION("view over buffer") {
+        splx::PiecewiseCurveView<double, 3> view(buffer.data(), buffer.size());
+        REQUIRE(view.numPieces() == 3);
+        REQUIRE(view.maxParameter() == piecewiseCurve.maxParameter());
+        REQUIRE(view.pieceMaxParameter(1) == 2);
+        REQUIRE(view.pieceControlPoints(2).cols() == 2);
+
+        for(double u = 0; u <= 6; u += 0.05) {
+            auto res = view.evalDerivatives(u, 3);
+            for(unsigned int k = 0; k <= 3; k++) {
+                REQUIRE((view.eval(u, k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+                REQUIRE((view.eval<splx::ClampPolicy>(u, k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+                REQUIRE((res.col(k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+
+        auto copy = view.toPiecewiseCurve();
+        REQUIRE(copy.numPieces() == 3);
+        REQUIRE((copy.eval(4.2, 1) - piecewiseCurve.eval(4.2, 1)).squaredNorm() < double_eq_epsilon);
+
+        REQUIRE_THROWS_AS(view.eval(6.1, 0), std::domain_error);
+        REQUIRE_THROWS_AS(view.pieceControlPoints(3), std::domain_error);
+    }
+
+    SECTION("invalid buffers") {
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<double, 3>(buffer.data(), 10)), std::domain_error);
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<double, 3>(buffer.data(), buffer.size() - 1)), std::domain_error);
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<double, 2>(buffer.data(), buffer.size())), std::domain_error);
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<float, 3>(buffer.data(), buffer.size())), std::domain_error);
+
+        std::vector<char> corrupted = buffer;
+        corrupted[0] = 'X';
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<double, 3>(corrupted.data(), corrupted.size())), std::domain_error);
+        splx::io::BinaryHeader header;
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        auto withValue = [&buffer](std::size_t at, auto value) {
+            std::vector<char> result = buffer;
+            std::memcpy(result.data() + at, &value, sizeof(value));
+            return result;
+        };
+        auto isValid = [](const std::vector<char>& buf) {
+            try {
+                splx::PiecewiseCurveView<double, 3>(buf.data(), buf.size());
+                return true;
+            } catch(const std::domain_error&) {
+                return false;
+            }
+        };
+
+        // piece 2 has 2 of the 10 control points
+        const std::size_t piece2 = header.pieceTableOffset + 2 * sizeof(splx::io::BinaryPiece);
+        REQUIRE(isValid(withValue(piece2, std::uint64_t(8))));
+        REQUIRE(!isValid(withValue(piece2, std::uint64_t(9))));
+        REQUIRE(!isValid(withValue(piece2, std::numeric_limits<std::uint64_t>::max())));
+        REQUIRE(!isValid(withValue(piece2 + sizeof(std::uint64_t), std::numeric_limits<std::uint64_t>::max())));
+
+        REQUIRE(!isValid(withValue(header.durationsOffset + sizeof(double), std::numeric_limits<double>::quiet_NaN())));
+        REQUIRE(!isValid(withValue(header.durationsOffset, -1.0)));
+        REQUIRE(!isValid(withValue(header.endsOffset + sizeof(double), 0.5)));
+        REQUIRE(!isValid(withValue(header.endsOffset + 2 * sizeof(double), std::numeric_limits<double>::infinity())));
+
+        // section sizes of these counts do not fit in 64 bits
+        REQUIRE(!isValid(withValue(offsetof(splx::io::BinaryHeader, numPieces), std::uint64_t(1) << 62)));
+        REQUIRE(!isValid(withValue(offsetof(splx::io::BinaryHeader, numControlPoints), std::uint64_t(1) << 62)));
+        REQUIRE_THROWS_AS((splx::io::internal::makeHeader<double, 3>(1, std::numeric_limits<std::uint64_t>::max())), std::domain_error);
+
+        REQUIRE(!isValid(withValue(offsetof(splx::io::BinaryHeader, version), std::uint32_t(1))));
+        REQUIRE(!isValid(withValue(offsetof(splx::io::BinaryHeader, byteOrder), std::uint64_t(0x0807060504030201))));
+
+        std::vector<char> shifted(buffer.size() + 1);
+        std::memcpy(shifted.data() + 1, buffer.data(), buffer.size());
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<double, 3>(shifted.data() + 1, buffer.size())), std::domain_error);
+    }
+
+    SECTION("alignment of float buffers") {
+        splx::PiecewiseCurve<float, 3> floatCurve;
+        floatCurve.addPiece(splx::Bezier<float, 3>{1.5f, {{1, 2, 3}, {3, 2, 1}, {-5, -5, -5}}});
+        const std::vector<char> floatBuffer = splx::io::toBinary(floatCurve);
+
+        // aligned to the floats but not to the 64 bit fields of the piece table
+        std::vector<std::uint64_t> storage(floatBuffer.size() / sizeof(std::uint64_t) + 2);
+        char* aligned = reinterpret_cast<char*>(storage.data());
+        std::memcpy(aligned, floatBuffer.data(), floatBuffer.size());
+        std::memcpy(aligned + sizeof(float), floatBuffer.data(), floatBuffer.size());
+        REQUIRE_THROWS_AS((splx::PiecewiseCurveView<float, 3>(aligned + sizeof(float), floatBuffer.size())), std::domain_error);
+
+        std::memcpy(aligned, floatBuffer.data(), floatBuffer.size());
+        splx::PiecewiseCurveView<float, 3> view(aligned, floatBuffer.size());
+        REQUIRE((view.eval(0.7f, 1) - floatCurve.eval(0.7f, 1)).squaredNorm() < 1e-8);
+    }
+
+    SECTION("memory mapped file") {
+        const std::string path = "piecewise_curve_view_test.splx";
+        splx::io::writeBinary(piecewiseCurve, path);
+
+        {
+            splx::io::MappedFile file(path);
+            REQUIRE(file.size() == buffer.size());
+
+            splx::PiecewiseCurveView<double, 3> view(file.data(), file.size());
+            for(double u : {0.0, 1.2, 3.5, 5.7, 6.0}) {
+                REQUIRE((view.eval(u, 0) - piecewiseCurve.eval(u, 0)).squaredNorm() < double_eq_epsilon);
+            }
+        }
+
+        std::remove(path.c_str());
+        REQUIRE_THROWS_AS(splx::io::MappedFile(path), std::runtime_error);
+    }
+}
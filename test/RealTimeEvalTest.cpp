@@ -0,0 +1,160 @@
+#define CATCH_CONFIG_MAIN
+#define EIGEN_RUNTIME_NO_MALLOC
+#include "catch.hpp"
+
+#include <splx/curve/Bezier.hpp>
+#include <splx/curve/PiecewiseCurve.hpp>
+#include <splx/internal/bezier.hpp>
+#include <splx/policies.hpp>
+#include <cstdlib>
+#include <new>
+
+/*
+* Allocations are checked twice. Eigen allocates with std::malloc, which
+* EIGEN_RUNTIME_NO_MALLOC guards. Standard containers and strings allocate
+* through global operator new, which is replaced to count them. operator
+* delete is not inlined, otherwise gcc takes its std::free for a mismatched
+* deallocation of memory from operator new.
+*/
+namespace {
+    // number of allocations made through global operator new
+    std::size_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+TEST_CASE("policies", "[policies]") {
+    REQUIRE(splx::ClampPolicy::apply(-1.0, 2.0) == 0.0);
+    REQUIRE(splx::ClampPolicy::apply(3.0, 2.0) == 2.0);
+    REQUIRE(splx::ClampPolicy::apply(1.5, 2.0) == 1.5);
+
+    REQUIRE(splx::WrapPolicy::apply(2.5, 2.0) == Approx(0.5));
+    REQUIRE(splx::WrapPolicy::apply(-0.5, 2.0) == Approx(1.5));
+    REQUIRE(splx::WrapPolicy::apply(1.0, 0.0) == 0.0);
+
+    REQUIRE(splx::AssertPolicy::apply(1.0, 2.0) == 1.0);
+}
+
+TEST_CASE("real time evaluation does not allocate", "[realtime]") {
+    using Bez = splx::Bezier<double, 3>;
+    using VectorDIM = Bez::VectorDIM;
+    using Row = Bez::Row;
+
+    double double_eq_epsilon = 1e-13;
+
+    Bez bez(2.5, {{1, 2, 3}, {3, 2, 1}, {2, 2.3, 3.4}, {3, 2.2, 3.1}, {-5, -5, -5}});
+    splx::Bezier<double, 3, 4> fixedBez(bez);
+
+    splx::PiecewiseCurve<double, 3> piecewiseCurve;
+    piecewiseCurve.addPiece(bez);
+    piecewiseCurve.addPiece(Bez(1.5, {{-5, -5, -5}, {1, 1, 1}, {2, 0, 2}}));
+
+    SECTION("results match checked evaluation") {
+        for(unsigned int k = 0; k < 6; k++) {
+            for(double u : {0.0, 0.7, 2.5}) {
+                REQUIRE((bez.eval<splx::ClampPolicy>(u, k) - bez.eval(u, k)).squaredNorm() < double_eq_epsilon);
+                REQUIRE((bez.eval<splx::AssertPolicy>(u, k) - bez.eval(u, k)).squaredNorm() < double_eq_epsilon);
+                REQUIRE((fixedBez.eval<splx::ClampPolicy>(u, k) - bez.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+
+            for(double u : {0.0, 1.3, 2.5, 3.9, 4.0}) {
+                REQUIRE((piecewiseCurve.eval<splx::ClampPolicy>(u, k) - piecewiseCurve.eval(u, k)).squaredNorm() < double_eq_epsilon);
+            }
+
+            REQUIRE((bez.eval<splx::ClampPolicy>(-1, k) - bez.eval(0, k)).squaredNorm() < double_eq_epsilon);
+            REQUIRE((bez.eval<splx::ClampPolicy>(3, k) - bez.eval(2.5, k)).squaredNorm() < double_eq_epsilon);
+            REQUIRE((bez.eval<splx::WrapPolicy>(3, k) - bez.eval(0.5, k)).squaredNorm() < double_eq_epsilon);
+            REQUIRE((piecewiseCurve.eval<splx::ClampPolicy>(5, k) - piecewiseCurve.eval(4, k)).squaredNorm() < double_eq_epsilon);
+            REQUIRE((piecewiseCurve.eval<splx::WrapPolicy>(5, k) - piecewiseCurve.eval(1, k)).squaredNorm() < double_eq_epsilon);
+        }
+
+        REQUIRE(splx::PiecewiseCurve<double, 3>().eval<splx::ClampPolicy>(1, 0) == VectorDIM::Zero());
+    }
+
+    SECTION("no allocations") {
+        Row row(bez.numControlPoints());
+        VectorDIM sum = VectorDIM::Zero();
+
+        // eigen asserts if it allocates while malloc is not allowed
+        const std::size_t before = allocationCount;
+        Eigen::internal::set_is_malloc_allowed(false);
+        for(unsigned int k = 0; k < 6; k++) {
+            for(double u = -1; u <= 5; u += 0.01) {
+                sum += bez.eval<splx::ClampPolicy>(u, k);
+                sum += bez.eval<splx::WrapPolicy>(u, k);
+                sum += fixedBez.eval<splx::ClampPolicy>(u, k);
+                sum += piecewiseCurve.eval<splx::ClampPolicy>(u, k);
+                sum += piecewiseCurve.eval<splx::WrapPolicy>(u, k);
+                splx::internal::bezier::getBasisRow<splx::ClampPolicy>(
+                    bez.degree(), bez.maxParameter(), u, k, row
+                );
+                sum(0) += row.sum();
+            }
+        }
+        Eigen::internal::set_is_malloc_allowed(true);
+        const std::size_t after = allocationCount;
+
+        REQUIRE(after == before);
+        REQUIRE(sum.allFinite());
+    }
+}
+
+TEST_CASE("reserved piecewise curve construction", "[realtime]") {
+    using Bez = splx::Bezier<double, 3>;
+
+    Bez bez(0.1, {{1, 2, 3}, {3, 2, 1}, {2, 2.3, 3.4}, {-5, -5, -5}});
+    bez.boundingBox();
+    const auto cpts = bez.controlPointMatrix();
+
+    splx::PiecewiseCurve<double, 3> piecewiseCurve;
+    piecewiseCurve.reserve(1000, 4000);
+
+    piecewiseCurve.addPiece(bez);
+    const double* data = piecewiseCurve.pieceControlPoints(0).data();
+
+    // control points are stored in eigen aligned storage, which asserts if
+    // it allocates while malloc is not allowed. pieces, durations and their
+    // counts are in standard containers, which are counted.
+    const std::size_t before = allocationCount;
+    Eigen::internal::set_is_malloc_allowed(false);
+    for(unsigned int i = 0; i < 500; i++) {
+        piecewiseCurve.emplacePiece(0.1, cpts);
+        if(i < 499) {
+            piecewiseCurve.addPiece(bez);
+        }
+    }
+    Eigen::internal::set_is_malloc_allowed(true);
+    const std::size_t after = allocationCount;
+
+    REQUIRE(after == before);
+    REQUIRE(piecewiseCurve.pieceControlPoints(0).data() == data);
+    REQUIRE(piecewiseCurve.numPieces() == 1000);
+    REQUIRE((piecewiseCurve.eval(99.95, 0) - bez.eval(0.05, 0)).squaredNorm() < 1e-13);
+}
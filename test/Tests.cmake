@@ -12,4 +12,8 @@ endfunction(generate_test)
 
 generate_test(BezierTest)
 generate_test(PiecewiseCurveTest)
-generate_test(PiecewiseCurveQPGeneratorTest)
\ No newline at end of file
+generate_test(PiecewiseCurveQPGeneratorTest)
+generate_test(RealTimeEvalTest)
+generate_test(HorizonCurveTest)
+generate_test(PiecewiseCurveViewTest)
+generate_test(TrajectoryChannelTest)
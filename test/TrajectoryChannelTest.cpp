@@ -0,0 +1,77 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <splx/curve/Bezier.hpp>
+#include <splx/curve/PiecewiseCurve.hpp>
+#include <splx/curve/TrajectoryChannel.hpp>
+#include <thread>
+
+TEST_CASE("", "[TrajectoryChannel]") {
+    using PiecewiseCurve = splx::PiecewiseCurve<double, 3>;
+    using VectorDIM = PiecewiseCurve::VectorDIM;
+
+    // curve i is constant at (i, i, i) with i + 1 pieces
+    auto makeCurve = [](unsigned int i) {
+        PiecewiseCurve curve;
+        for(unsigned int j = 0; j <= i; j++) {
+            curve.addPiece(splx::Bezier<double, 3>{1, {VectorDIM::Constant(i), VectorDIM::Constant(i)}});
+        }
+        return curve;
+    };
+
+    splx::TrajectoryChannel<double, 3> channel;
+    REQUIRE(!channel.hasUpdate());
+    REQUIRE(channel.read() == nullptr);
+
+    SECTION("single thread") {
+        auto snapshot = std::make_shared<const PiecewiseCurve>(makeCurve(1));
+        channel.publish(snapshot);
+        REQUIRE(channel.hasUpdate());
+        REQUIRE(channel.read() == snapshot);
+        REQUIRE(!channel.hasUpdate());
+        REQUIRE(channel.read() == snapshot);
+
+        channel.publish(makeCurve(2));
+        channel.publish(makeCurve(3));
+        REQUIRE(channel.read()->numPieces() == 4);
+        REQUIRE(channel.read()->eval(2.5, 0) == VectorDIM::Constant(3));
+
+        // the first snapshot is released by the writer once its slot is reused
+        channel.publish(makeCurve(4));
+        channel.publish(makeCurve(5));
+        REQUIRE(snapshot.use_count() == 1);
+    }
+
+    SECTION("writer and reader threads") {
+        const unsigned int numCurves = 200;
+        std::thread writer([&]() {
+            for(unsigned int i = 0; i < numCurves; i++) {
+                auto snapshot = std::make_shared<const PiecewiseCurve>(makeCurve(i));
+                channel.publish(snapshot);
+
+                // the writer keeps querying what it published
+                snapshot->arcLength();
+                snapshot->piecesNear(VectorDIM::Constant(i), 1);
+            }
+        });
+
+        bool consistent = true;
+        unsigned int last = 0;
+        while(last + 1 < numCurves) {
+            const auto& snapshot = channel.read();
+            if(snapshot == nullptr) {
+                continue;
+            }
+
+            const unsigned int i = snapshot->numPieces() - 1;
+            consistent = consistent && i >= last
+                && snapshot->eval(snapshot->maxParameter(), 0) == VectorDIM::Constant(i)
+                && snapshot->arcLength() == 0
+                && snapshot->piecesNear(VectorDIM::Constant(i), 1).size() == i + 1;
+            last = i;
+        }
+        writer.join();
+
+        REQUIRE(consistent);
+        REQUIRE(channel.read()->numPieces() == numCurves);
+    }
+}